@@ -0,0 +1,109 @@
+#include "analysis/dbm.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace fdlang::analysis;
+
+using Clock = std::chrono::steady_clock;
+
+// Random matrix without negative cycles, `density' is the ratio of finite
+// entries
+DBM randomDBM(size_t n, double density, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> weight(0, 255);
+    std::uniform_real_distribution<double> coin(0, 1);
+    DBM m(n, DBM::INF);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            m[i][j] = i == j ? 0 : coin(rng) < density ? weight(rng) : DBM::INF;
+    return m;
+}
+
+// Average time of `op' in nanoseconds, `prepare' is not timed
+double measure(size_t reps, const std::function<void()> &prepare,
+               const std::function<void()> &op) {
+    double total = 0;
+    for (size_t r = 0; r < reps; r++) {
+        prepare();
+        auto start = Clock::now();
+        op();
+        total += std::chrono::duration<double, std::nano>(Clock::now() - start)
+                     .count();
+    }
+    return total / reps;
+}
+
+int main() {
+    std::vector<std::pair<DBMKernel, const char *>> kernels = {
+        {DBMKernel::Scalar, "scalar"},
+        {DBMKernel::SSE41, "sse4.1"},
+        {DBMKernel::AVX2, "avx2"}};
+    const char *ops[] = {"close", "lub", "leq", "eq"};
+
+    printf("%6s %8s %8s %14s %8s\n", "n", "op", "kernel", "ns/op", "speedup");
+    for (size_t n : {16, 64, 256}) {
+        DBM a = randomDBM(n, 0.3, 1), b = randomDBM(n, 0.3, 2);
+        a.close();
+        b.close();
+        DBM open = randomDBM(n, 0.3, 3);
+        DBM work;
+        bool sink = false;
+        size_t reps = n <= 64 ? 2000 : 20;
+
+        for (const char *op : ops) {
+            double scalarTime = 0;
+            for (auto [kernel, name] : kernels) {
+                if (!DBM::useKernel(kernel))
+                    continue;
+                double t = 0;
+                std::string o = op;
+                if (o == "close")
+                    t = measure(
+                        reps, [&] { work = open; }, [&] { work.close(); });
+                else if (o == "lub")
+                    t = measure(
+                        reps * 50, [&] { work = a; }, [&] { work.maxWith(b); });
+                else if (o == "leq")
+                    t = measure(
+                        reps * 50, [] {}, [&] { sink ^= a.leq(a); });
+                else
+                    t = measure(
+                        reps * 50, [] {}, [&] { sink ^= a.eq(a); });
+                if (kernel == DBMKernel::Scalar)
+                    scalarTime = t;
+                printf("%6zu %8s %8s %14.1f %7.2fx\n", n, op, name, t,
+                       scalarTime / t);
+            }
+        }
+        if (sink)
+            printf("\n");
+    }
+
+    DBM::useKernel(DBMKernel::Best);
+
+    // Plain triple loop against the blocked closure on 2 and 4 threads
+    printf("\n%6s %8s %14s %8s\n", "n", "threads", "ns/close", "speedup");
+    for (size_t n : {256, 512, 1024}) {
+        DBM open = randomDBM(n, 0.3, 3), work;
+        size_t reps = n <= 512 ? 5 : 2;
+
+        DBM::useThreads(1, SIZE_MAX);
+        double plainTime = measure(
+            reps, [&] { work = open; }, [&] { work.close(); });
+        printf("%6zu %8s %14.1f %7.2fx\n", n, "plain", plainTime, 1.0);
+        for (size_t threads : {2, 4}) {
+            DBM::useThreads(threads, 1);
+            double t = measure(
+                reps, [&] { work = open; }, [&] { work.close(); });
+            printf("%6zu %8zu %14.1f %7.2fx\n", n, threads, t, plainTime / t);
+        }
+    }
+
+    DBM::useThreads(1);
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include "fdlang/AST.h"
+#include "fdlang/flatAST.h"
+#include "fdlang/parser.h"
+#include "fdlang/scanner.h"
+#include "fdlang/sema.h"
+
+#include "IR/IRBuilder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+
+using namespace fdlang;
+
+using Clock = std::chrono::steady_clock;
+
+// Random statements nested up to `depth', about `bytes' bytes in total
+std::string randomProgram(size_t bytes, size_t depth, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> value(0, 255);
+    auto var = [&] { return "v" + std::to_string(value(rng) % 64); };
+
+    std::string src;
+    size_t open = 0;
+    while (src.size() < bytes || open > 0) {
+        int kind = value(rng) % 8;
+        if (src.size() >= bytes || (open > 0 && kind == 0)) {
+            src += "}\n";
+            open--;
+        } else if (kind == 1 && open < depth) {
+            src += "while (" + var() + " < " + std::to_string(value(rng)) +
+                   ") {\n";
+            open++;
+        } else if (kind == 2) {
+            src += var() + " = input();\n";
+        } else if (kind == 3) {
+            src += "check_interval(" + var() + ", 0, 255);\n";
+        } else {
+            src += var() + " = " + var() + " + " + std::to_string(value(rng)) +
+                   ";\n";
+        }
+    }
+    return src;
+}
+
+double since(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start)
+        .count();
+}
+
+int main() {
+    printf("%8s %6s %8s %10s %10s %10s %10s\n", "MB", "depth", "ast",
+           "parse ms", "sema ms", "ir ms", "free ms");
+    for (size_t depth : {0, 8}) {
+        std::string src = randomProgram(32 << 20, depth, depth + 1);
+        double mb = src.size() / double(1 << 20);
+
+        {
+            Scanner scanner(src);
+            Parser parser(scanner);
+            auto start = Clock::now();
+            ASTNode *root = parser.parse();
+            double parse = since(start);
+            start = Clock::now();
+            bool ok = Sema(root).check();
+            double sema = since(start);
+            start = Clock::now();
+            IR::IRBuilder irBuilder(root);
+            size_t insts = irBuilder.build().size();
+            double ir = since(start);
+            start = Clock::now();
+            delete root;
+            double free = since(start);
+            printf("%8.1f %6zu %8s %10.1f %10.1f %10.1f %10.1f\n", mb, depth,
+                   "tree", parse, sema, ir, free);
+            if (!ok || parser.hadError() || insts == 0)
+                printf("bad program\n");
+        }
+
+        {
+            Scanner scanner(src);
+            Parser parser(scanner);
+            auto start = Clock::now();
+            FlatAST *ast = new FlatAST(parser.parseFlat());
+            double parse = since(start);
+            start = Clock::now();
+            bool ok = Sema(*ast).check();
+            double sema = since(start);
+            start = Clock::now();
+            IR::IRBuilder irBuilder(*ast);
+            size_t insts = irBuilder.build().size();
+            double ir = since(start);
+            start = Clock::now();
+            delete ast;
+            double free = since(start);
+            printf("%8.1f %6zu %8s %10.1f %10.1f %10.1f %10.1f\n", mb, depth,
+                   "flat", parse, sema, ir, free);
+            if (!ok || parser.hadError() || insts == 0)
+                printf("bad program\n");
+        }
+    }
+    return 0;
+}
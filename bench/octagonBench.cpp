@@ -0,0 +1,129 @@
+#include "fdlang/parser.h"
+#include "fdlang/scanner.h"
+#include "fdlang/sema.h"
+
+#include "analysis/relationalNumericalAnalysis.h"
+
+#include "IR/IRBuilder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace fdlang;
+using ZoneKind = analysis::RelationalNumericalAnalysis::ZoneKind;
+
+using Clock = std::chrono::steady_clock;
+
+std::string readSrc(const std::string &path) {
+    std::ifstream file(path);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+// Random program over `vars' variables with sums and differences, guards,
+// and counting loops nested at most twice
+std::string generate(size_t vars, size_t stmts, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> var(0, vars - 1);
+    std::uniform_int_distribution<int> small(0, 5), constant(1, 250);
+    std::uniform_real_distribution<double> coin(0, 1);
+    auto v = [&] { return "v" + std::to_string(var(rng)); };
+
+    std::function<std::string(int)> stmt = [&](int depth) -> std::string {
+        double r = coin(rng);
+        std::string x = v();
+        if (r < 0.2)
+            return x + " = " + v() + " + " + std::to_string(small(rng)) + ";";
+        if (r < 0.3)
+            return x + " = " + v() + " - " + std::to_string(small(rng)) + ";";
+        if (r < 0.4)
+            return x + " = " + v() + " + " + v() + ";";
+        if (r < 0.5)
+            return x + " = " + v() + " - " + v() + ";";
+        if (r < 0.6)
+            return x + " = " + std::to_string(constant(rng)) + " - " + v() +
+                   ";";
+        if (r < 0.7 && depth < 2)
+            return "if (" + x + " < " + std::to_string(constant(rng)) +
+                   ") {\n" + stmt(depth + 1) + "\n} else {\n" +
+                   stmt(depth + 1) + "\n}";
+        if (r < 0.8 && depth < 2)
+            return x + " = 0;\nwhile (" + x + " < " +
+                   std::to_string(constant(rng) % 30 + 1) + ") {\n" + x +
+                   " = " + x + " + 1;\n" + stmt(depth + 1) + "\n}";
+        return "check_interval(" + x + ", 0, " +
+               std::to_string(constant(rng)) + ");";
+    };
+
+    std::string src;
+    for (size_t i = 0; i < vars; i++)
+        src += "v" + std::to_string(i) + " = input();\n";
+    for (size_t i = 0; i < stmts; i++)
+        src += stmt(0) + "\n";
+    return src;
+}
+
+struct Result {
+    double ms;
+    size_t proved;
+};
+
+// Average time of the analysis of `src' and the number of checks it proves
+Result analyze(const std::string &src, ZoneKind kind, size_t reps) {
+    Scanner scanner(src);
+    Parser parser(scanner);
+    ASTNode *root = parser.parse();
+    Sema sema(root);
+    if (scanner.hadError() || parser.hadError() || !sema.check())
+        return {0, 0};
+    IR::IRBuilder irBuilder(root);
+    IR::Insts insts = irBuilder.build();
+
+    std::string output;
+    auto start = Clock::now();
+    for (size_t r = 0; r < reps; r++) {
+        analysis::RelationalNumericalAnalysis analysis(insts, kind);
+        analysis.run();
+        std::stringstream ss;
+        analysis.dumpResult(ss);
+        output = ss.str();
+    }
+    double ms =
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count() /
+        reps;
+
+    size_t proved = 0;
+    for (size_t pos = 0; (pos = output.find("YES", pos)) != output.npos;
+         pos++)
+        proved++;
+    return {ms, proved};
+}
+
+void compare(const std::string &name, const std::string &src, size_t reps) {
+    Result zone = analyze(src, ZoneKind::Dense, reps);
+    Result octagon = analyze(src, ZoneKind::Octagon, reps);
+    printf("%-14s %10.3f %6zu %10.3f %6zu %7.2fx\n", name.c_str(), zone.ms,
+           zone.proved, octagon.ms, octagon.proved, octagon.ms / zone.ms);
+}
+
+int main() {
+    printf("%-14s %10s %6s %10s %6s %8s\n", "program", "zone ms", "YES",
+           "octagon ms", "YES", "cost");
+    for (const char *file : {"rel1", "rel2", "rel3", "rel4"})
+        compare(file, readSrc(TESTCASES_DIR "/" + std::string(file) +
+                              ".fdlang"),
+                200);
+
+    for (size_t vars : {8, 16, 32, 64})
+        compare("gen-" + std::to_string(vars),
+                generate(vars, vars * 8, (unsigned)vars), vars <= 16 ? 20 : 3);
+    return 0;
+}
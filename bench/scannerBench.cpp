@@ -0,0 +1,83 @@
+#include "fdlang/scanner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace fdlang;
+
+using Clock = std::chrono::steady_clock;
+
+// Random statements of about `bytes' bytes over 256 variables, `width' is
+// the longest name. Few names are distinct, as in real programs, so that the
+// symbol table does not dominate
+std::string randomProgram(size_t bytes, size_t width, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> length(1, width);
+    std::uniform_int_distribution<int> letter(0, 25), value(0, 255);
+    std::vector<std::string> names(256);
+    for (std::string &s : names)
+        for (size_t n = length(rng); s.size() < n;)
+            s += 'a' + letter(rng);
+    auto name = [&] { return names[value(rng)]; };
+
+    std::string src;
+    while (src.size() < bytes) {
+        switch (value(rng) % 4) {
+        case 0:
+            src += "    " + name() + " = input();\n";
+            break;
+        case 1:
+            src += "    " + name() + " = " + name() + " + " +
+                   std::to_string(value(rng)) + ";\n";
+            break;
+        case 2:
+            src += "    while (" + name() + " < " +
+                   std::to_string(value(rng)) + ") {\n        nop;\n    }\n";
+            break;
+        default:
+            src += "    check_interval(" + name() + ", 0, 255);\n\n";
+            break;
+        }
+    }
+    return src;
+}
+
+int main() {
+    std::vector<std::pair<ScanKernel, const char *>> kernels = {
+        {ScanKernel::Scalar, "scalar"},
+        {ScanKernel::SSE2, "sse2"},
+        {ScanKernel::AVX2, "avx2"}};
+
+    printf("%8s %8s %8s %12s %8s\n", "MB", "width", "kernel", "MB/s",
+           "speedup");
+    for (size_t width : {4, 16, 64}) {
+        std::string src = randomProgram(64 << 20, width, width);
+        double mb = src.size() / double(1 << 20);
+        double scalarRate = 0;
+        size_t sink = 0;
+
+        for (auto [kernel, name] : kernels) {
+            if (!Scanner::useKernel(kernel))
+                continue;
+            double best = 1e300;
+            for (int r = 0; r < 3; r++) {
+                auto start = Clock::now();
+                sink += Scanner(src).scanTokens().size();
+                std::chrono::duration<double> t = Clock::now() - start;
+                best = std::min(best, t.count());
+            }
+            double rate = mb / best;
+            if (kernel == ScanKernel::Scalar)
+                scalarRate = rate;
+            printf("%8.1f %8zu %8s %12.1f %7.2fx\n", mb, width, name, rate,
+                   rate / scalarRate);
+        }
+        if (sink == 0)
+            printf("no tokens\n");
+    }
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include "analysis/fixedZoneDomain.h"
+#include "analysis/zoneDomain.h"
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace fdlang::analysis;
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the tests from being optimized out
+bool sink = false;
+
+// Average time in nanoseconds of a random walk of `ops' assignments and
+// guards, joined into and widened with a summary every few steps
+template <typename Zone>
+double run(const std::shared_ptr<const VarEnv> &env, size_t ops,
+           unsigned seed) {
+    std::mt19937 rng(seed);
+    size_t n = env->size();
+    std::uniform_int_distribution<size_t> var(1, n - 1);
+    std::uniform_int_distribution<int> constant(0, 20);
+    std::uniform_int_distribution<int> kind(0, 3);
+    std::vector<long long> thresholds = {0, 255};
+
+    auto start = Clock::now();
+    Zone zone(env, true), joined(env, false);
+    for (size_t i = 0; i < ops; i++) {
+        size_t x = var(rng), y = var(rng);
+        switch (kind(rng)) {
+        case 0:
+            zone.assign(x, y, constant(rng));
+            break;
+        case 1:
+            zone.assign(x, x, 1);
+            break;
+        case 2:
+            zone.assignInterval(x, 0, constant(rng) * 10);
+            break;
+        default:
+            zone.filter(x, 0, 200 + constant(rng));
+        }
+        if (zone.isEmpty())
+            zone = Zone(env, true);
+        if (i % 4 == 0) {
+            sink ^= zone.leq(joined);
+            joined.joinWith(zone);
+        }
+        if (i % 64 == 0) {
+            Zone widened = joined;
+            widened.widenWith(zone, thresholds);
+            sink ^= widened.eq(joined);
+        }
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start)
+               .count() /
+           ops;
+}
+
+template <size_t N> void compare(size_t vars) {
+    std::vector<fdlang::Symbol> symbols;
+    for (size_t i = 0; i < vars; i++)
+        symbols.push_back(
+            fdlang::SymbolTable::get().intern("v" + std::to_string(i)));
+    auto env = std::make_shared<const VarEnv>(symbols);
+
+    size_t ops = 200000;
+    double dynamic = run<ZoneDomain>(env, ops, 1);
+    double fixed = run<FixedZoneDomain<N>>(env, ops, 1);
+    printf("%6zu %6zu %14.1f %14.1f %7.2fx\n", vars, N, dynamic, fixed,
+           dynamic / fixed);
+}
+
+int main() {
+    printf("%6s %6s %14s %14s %8s\n", "vars", "N", "dynamic ns/op",
+           "fixed ns/op", "speedup");
+    compare<4>(3);
+    compare<8>(7);
+    compare<16>(12);
+    compare<16>(15);
+    compare<32>(24);
+    compare<32>(31);
+    if (sink)
+        printf("\n");
+    return 0;
+}
@@ -3,7 +3,6 @@
 
 #include "fdlang/token.h"
 
-#include <any>
 #include <assert.h>
 #include <iostream>
 #include <string>
@@ -38,18 +37,19 @@ std::string getCmpOperatorSpelling(CmpOperator op);
 class Value {
 private:
     ValueType type;
-    std::any value;
+    // The number, or the `Symbol' of the variable
+    long long value;
 
 public:
     Value(const Token &token) {
         if (token.type == TokenType::IDENTIFIER) {
-            value = token.lexeme;
+            value = token.getSymbol();
             type = ValueType::Variable;
         } else if (token.type == TokenType::NUMBER) {
             value = token.getLiteralAsNumber();
             type = ValueType::Number;
         } else {
-            assert(false && "Value must be long long integer or std::string!");
+            assert(false && "Value must be a number or an identifier!");
         }
     }
 
@@ -59,12 +59,16 @@ public:
 
     long long getAsNumber() {
         assert(isNumber());
-        return std::any_cast<long long>(value);
+        return value;
     }
 
-    std::string getAsVariable() {
+    Symbol getAsVariable() {
         assert(isVariable());
-        return std::any_cast<std::string>(value);
+        return value;
+    }
+
+    const std::string &getVariableName() {
+        return SymbolTable::get().getName(getAsVariable());
     }
 
     void dump(std::ostream &out, bool showType = false) {
@@ -72,12 +76,12 @@ public:
             if (isNumber())
                 out << "Number(" << getAsNumber() << ")";
             else if (isVariable())
-                out << "Var(" << getAsVariable() << ")";
+                out << "Var(" << getVariableName() << ")";
         } else {
             if (isNumber())
                 out << getAsNumber();
             else if (isVariable())
-                out << getAsVariable();
+                out << getVariableName();
         }
     }
 };
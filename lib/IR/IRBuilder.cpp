@@ -1,4 +1,5 @@
 #include "IRBuilder.h"
+#include "fdlang/sema.h"
 #include "fdlang/token.h"
 
 using namespace fdlang;
@@ -31,7 +32,29 @@ Inst *IRBuilder::lastInst() {
 
 Insts IRBuilder::build() {
     IR.clear();
-    root->accept(this);
+    if (flat)
+        lower(*flat, 0);
+    else
+        append(root);
+    return finish();
+}
+
+void IRBuilder::append(ASTNode *node) { node->accept(this); }
+
+bool IRBuilder::stream(Parser &parser) {
+    // Keep checking after an error so that all of them are reported, but
+    // stop lowering
+    bool ok = true;
+    while (ASTNode *stmt = parser.parseTopLevel()) {
+        ok = Sema(stmt).check() && ok;
+        if (ok)
+            append(stmt);
+        delete stmt;
+    }
+    return ok && !parser.hadError();
+}
+
+Insts IRBuilder::finish() {
     std::vector<Inst *> ret;
     for (size_t id = 0; id < IR.size(); id++) {
         Inst *inst = IR[id].get();
@@ -68,47 +91,112 @@ void IRBuilder::visit(Stmts *node) {
 void IRBuilder::visit(Cond *node) {}
 
 void IRBuilder::visit(UnaryAssignStmt *node) {
-    switch (node->operand.type) {
+    lowerUnaryAssign(node->variable, node->operand);
+}
+
+void IRBuilder::visit(BinaryAssignStmt *node) {
+    lowerBinaryAssign(node->variable, node->leftOperand, node->op,
+                      node->rightOperand);
+}
+
+void IRBuilder::visit(IfStmt *node) {
+    Cond *cond = (Cond *)node->cond;
+    lowerIf(
+        cond->leftOperand, cond->op, cond->rightOperand,
+        [&] { node->trueBody->accept(this); },
+        [&] { node->falseBody->accept(this); });
+}
+
+void IRBuilder::visit(WhileStmt *node) {
+    Cond *cond = (Cond *)node->cond;
+    lowerWhile(cond->leftOperand, cond->op, cond->rightOperand,
+               [&] { node->body->accept(this); });
+}
+
+void IRBuilder::visit(CheckStmt *node) {
+    lowerCheck(node->check, node->params.data());
+}
+
+void IRBuilder::visit(NopStmt *node) {}
+
+void IRBuilder::lower(const FlatAST &ast, FlatAST::Index node) {
+    const Token *tokens = ast.getTokens(node);
+    switch (ast[node].type) {
+    case ASTNodeType::STMTS:
+        for (FlatAST::Index child = node + 1; child < ast[node].end;
+             child = ast[child].end)
+            lower(ast, child);
+        break;
+    case ASTNodeType::UNARY_ASSIGN_STMT:
+        lowerUnaryAssign(tokens[0], tokens[1]);
+        break;
+    case ASTNodeType::BINARY_ASSIGN_STMT:
+        lowerBinaryAssign(tokens[0], tokens[1], tokens[2], tokens[3]);
+        break;
+    case ASTNodeType::IF_STMT: {
+        const Token *cond = ast.getTokens(ast.getChild(node, 0));
+        lowerIf(
+            cond[0], cond[1], cond[2],
+            [&] { lower(ast, ast.getChild(node, 1)); },
+            [&] { lower(ast, ast.getChild(node, 2)); });
+        break;
+    }
+    case ASTNodeType::WHILE_STMT: {
+        const Token *cond = ast.getTokens(ast.getChild(node, 0));
+        lowerWhile(cond[0], cond[1], cond[2],
+                   [&] { lower(ast, ast.getChild(node, 1)); });
+        break;
+    }
+    case ASTNodeType::CHECK_STMT:
+        lowerCheck(tokens[0], tokens + 1);
+        break;
+    default:
+        break;
+    }
+}
+
+void IRBuilder::lowerUnaryAssign(const Token &variable, const Token &operand) {
+    switch (operand.type) {
     case TokenType::CALL_INPUT:
-        addInst(new InputInst(new Value(node->variable)));
+        addInst(new InputInst(new Value(variable)));
         break;
     case TokenType::IDENTIFIER:
     case TokenType::NUMBER:
-        addInst(new AssignInst(new Value(node->variable),
-                               new Value(node->operand)));
+        addInst(new AssignInst(new Value(variable), new Value(operand)));
         break;
     default:
         assert(false);
     }
 }
 
-void IRBuilder::visit(BinaryAssignStmt *node) {
-    switch (node->op.type) {
+void IRBuilder::lowerBinaryAssign(const Token &variable,
+                                  const Token &leftOperand, const Token &op,
+                                  const Token &rightOperand) {
+    switch (op.type) {
     case TokenType::PLUS:
-        addInst(new AddInst(new Value(node->variable),
-                            new Value(node->leftOperand),
-                            new Value(node->rightOperand)));
+        addInst(new AddInst(new Value(variable), new Value(leftOperand),
+                            new Value(rightOperand)));
         break;
     case TokenType::MINUS:
-        addInst(new SubInst(new Value(node->variable),
-                            new Value(node->leftOperand),
-                            new Value(node->rightOperand)));
+        addInst(new SubInst(new Value(variable), new Value(leftOperand),
+                            new Value(rightOperand)));
         break;
     default:
         assert(false);
     }
 }
 
-void IRBuilder::visit(IfStmt *node) {
-    Cond *cond = (Cond *)node->cond;
-
+void IRBuilder::lowerIf(const Token &leftOperand, const Token &op,
+                        const Token &rightOperand,
+                        const std::function<void()> &trueBody,
+                        const std::function<void()> &falseBody) {
     LabelInst *labelTrueBody = new LabelInst();
     LabelInst *labelFalseBody = new LabelInst();
     LabelInst *labelEnd = new LabelInst();
 
-    IfInst *ifInst = new IfInst(new Value(cond->leftOperand),
-                                TokenOpType2CmpOp(cond->op.type),
-                                new Value(cond->rightOperand), labelTrueBody);
+    IfInst *ifInst =
+        new IfInst(new Value(leftOperand), TokenOpType2CmpOp(op.type),
+                   new Value(rightOperand), labelTrueBody);
 
     GotoInst *gotoFalseBody = new GotoInst(labelFalseBody);
     GotoInst *gotoEnd = new GotoInst(labelEnd);
@@ -116,23 +204,23 @@ void IRBuilder::visit(IfStmt *node) {
     addInst(ifInst);
     addInst(gotoFalseBody);
     addInst(labelTrueBody);
-    node->trueBody->accept(this);
+    trueBody();
     addInst(gotoEnd);
     addInst(labelFalseBody);
-    node->falseBody->accept(this);
+    falseBody();
     addInst(labelEnd);
 }
 
-void IRBuilder::visit(WhileStmt *node) {
-    Cond *cond = (Cond *)node->cond;
-
+void IRBuilder::lowerWhile(const Token &leftOperand, const Token &op,
+                           const Token &rightOperand,
+                           const std::function<void()> &body) {
     LabelInst *labelStart = new LabelInst();
     LabelInst *labelBody = new LabelInst();
     LabelInst *labelEnd = new LabelInst();
 
-    IfInst *ifInst = new IfInst(new Value(cond->leftOperand),
-                                TokenOpType2CmpOp(cond->op.type),
-                                new Value(cond->rightOperand), labelBody);
+    IfInst *ifInst =
+        new IfInst(new Value(leftOperand), TokenOpType2CmpOp(op.type),
+                   new Value(rightOperand), labelBody);
 
     GotoInst *gotoStart = new GotoInst(labelStart);
     GotoInst *gotoEnd = new GotoInst(labelEnd);
@@ -141,17 +229,15 @@ void IRBuilder::visit(WhileStmt *node) {
     addInst(ifInst);
     addInst(gotoEnd);
     addInst(labelBody);
-    node->body->accept(this);
+    body();
     addInst(gotoStart);
     addInst(labelEnd);
 }
 
-void IRBuilder::visit(CheckStmt *node) {
-    CheckIntervalInst *checkIntervalInst = new CheckIntervalInst(
-        new Value(node->params[0]), new Value(node->params[1]),
-        new Value(node->params[2]));
-    checkIntervalInst->setLine(node->check.line);
+void IRBuilder::lowerCheck(const Token &check, const Token *params) {
+    CheckIntervalInst *checkIntervalInst =
+        new CheckIntervalInst(new Value(params[0]), new Value(params[1]),
+                              new Value(params[2]));
+    checkIntervalInst->setLine(check.line);
     addInst(checkIntervalInst);
-}
-
-void IRBuilder::visit(NopStmt *node) {}
\ No newline at end of file
+}
\ No newline at end of file
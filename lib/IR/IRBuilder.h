@@ -4,7 +4,10 @@
 #include "IR.h"
 
 #include "fdlang/ASTVisitor.h"
+#include "fdlang/flatAST.h"
+#include "fdlang/parser.h"
 
+#include <functional>
 #include <memory>
 
 namespace fdlang::IR {
@@ -12,6 +15,7 @@ namespace fdlang::IR {
 class IRBuilder : public ASTVisitor {
 private:
     ASTNode *root;
+    const FlatAST *flat = nullptr;
     std::vector<std::unique_ptr<Inst>> IR;
 
     void addInst(Inst *inst);
@@ -26,10 +30,49 @@ private:
     virtual void visit(CheckStmt *node) override;
     virtual void visit(NopStmt *node) override;
 
+    void lower(const FlatAST &ast, FlatAST::Index node);
+
+    // Shared by both ASTs, `lowerIf' and `lowerWhile' lower the bodies by
+    // calling back
+    void lowerUnaryAssign(const Token &variable, const Token &operand);
+    void lowerBinaryAssign(const Token &variable, const Token &leftOperand,
+                           const Token &op, const Token &rightOperand);
+    void lowerIf(const Token &leftOperand, const Token &op,
+                 const Token &rightOperand,
+                 const std::function<void()> &trueBody,
+                 const std::function<void()> &falseBody);
+    void lowerWhile(const Token &leftOperand, const Token &op,
+                    const Token &rightOperand,
+                    const std::function<void()> &body);
+    void lowerCheck(const Token &check, const Token *params);
+
 public:
-    IRBuilder(ASTNode *root) : root(root) {}
+    IRBuilder(ASTNode *root = nullptr) : root(root) {}
+
+    IRBuilder(const FlatAST &ast) : root(nullptr), flat(&ast) {}
 
+    /**
+     * @brief Lower the whole AST given at construction
+     */
     Insts build();
+
+    /**
+     * @brief Lower the top-level statement `node', which is not kept
+     */
+    void append(ASTNode *node);
+
+    /**
+     * @brief Pull, check and lower the top-level statements of `parser' one
+     * at a time, each freed once lowered
+     *
+     * Return false if the program has an error, which has been reported.
+     */
+    bool stream(Parser &parser);
+
+    /**
+     * @brief Link the instructions lowered so far into a CFG and get them
+     */
+    Insts finish();
 };
 
 } // namespace fdlang::IR
@@ -0,0 +1,40 @@
+#include "dataflowAnalysis.h"
+#include "zoneTransfer.h"
+
+using namespace fdlang;
+using namespace fdlang::analysis;
+
+void DataflowAnalysis::resolveOperands(const VarEnv &env) {
+    operands.assign(insts.size(), {});
+    for (auto inst : insts)
+        for (size_t i = 0; i < inst->getOperandSize(); i++)
+            if (inst->getOperand(i)->isVariable())
+                operands[inst->getLabel()][i] =
+                    env.getID(inst->getOperand(i)->getAsVariable());
+}
+
+void DataflowAnalysis::collectThresholds() {
+    thresholds = {0, 255};
+    for (auto inst : insts) {
+        if (inst->getInstType() == IR::InstType::IfInst) {
+            // Guards keep `x <= c - 1', `x <= c' or `x >= c + 1'
+            long long c = inst->getOperand(1)->getAsNumber();
+            thresholds.insert(thresholds.end(), {c - 1, c, c + 1});
+        }
+        if (inst->getInstType() == IR::InstType::CheckIntervalInst) {
+            thresholds.push_back(inst->getOperand(1)->getAsNumber());
+            thresholds.push_back(inst->getOperand(2)->getAsNumber());
+        }
+    }
+    std::sort(thresholds.begin(), thresholds.end());
+    thresholds.erase(std::unique(thresholds.begin(), thresholds.end()),
+                     thresholds.end());
+}
+
+void DataflowAnalysis::findLoopHeads() {
+    loopHeads.assign(insts.size(), false);
+    for (auto inst : insts)
+        for (auto succ : inst->getSuccessors())
+            if (succ->getLabel() <= inst->getLabel())
+                loopHeads[succ->getLabel()] = true;
+}
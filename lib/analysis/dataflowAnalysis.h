@@ -3,12 +3,87 @@
 
 #include "IR/IR.h"
 
+#include <algorithm>
+#include <array>
+#include <map>
+#include <ostream>
+#include <utility>
+#include <vector>
+
 namespace fdlang::analysis {
 
+class VarEnv;
+
 class DataflowAnalysis {
+public:
+    /**
+     * Loop heads are widened from their `WIDENING_DELAY + 1'-th join on, and
+     * the fixpoint is refined by at most `NARROWING_ROUNDS' decreasing passes
+     */
+    static constexpr size_t WIDENING_DELAY = 2;
+    static constexpr size_t NARROWING_ROUNDS = 4;
+
 protected:
     IR::Insts insts;
 
+    // label -> ids of the operands of the instruction, 0 for the constants
+    std::vector<std::array<size_t, 3>> operands;
+
+    // Sorted constants of the guards and the checks
+    std::vector<long long> thresholds;
+
+    // label -> whether it is the target of a backward edge
+    std::vector<bool> loopHeads;
+
+    /**
+     * @brief Resolve the variables of every instruction to their ids in `env'
+     * once, into `operands'
+     */
+    void resolveOperands(const VarEnv &env);
+
+    /**
+     * @brief Collect the widening thresholds: 0, 255, the constants of the
+     * checks and the values around the constants of the guards
+     */
+    void collectThresholds();
+
+    /**
+     * @brief Mark the targets of backward edges in `loopHeads'
+     */
+    void findLoopHeads();
+
+    /**
+     * @brief Print the result of every check, by line then label
+     *
+     * `ResultType' is the enum of the analysis, with `YES', `NO' and
+     * `UNREACHABLE'.
+     */
+    // DO NOT MODIFY THIS FUNCTION
+    template <typename ResultType>
+    static void
+    dumpResults(std::ostream &out,
+                const std::map<IR::CheckIntervalInst *, ResultType> &results) {
+        using Location = std::pair<size_t, size_t>;
+
+        std::vector<std::pair<Location, ResultType>> ans;
+        for (auto [checkInst, result] : results) {
+            ans.emplace_back(
+                (Location){checkInst->getLine(), checkInst->getLabel()},
+                result);
+        }
+        std::sort(ans.begin(), ans.end());
+
+        for (auto [loc, result] : ans) {
+            auto [line, label] = loc;
+            out << "Line " << line << ": ";
+            if (result == ResultType::UNREACHABLE) {
+                out << "Unreachable" << std::endl;
+                continue;
+            }
+            out << (result == ResultType::YES ? "YES" : " NO") << std::endl;
+        }
+    }
+
 public:
     DataflowAnalysis(const IR::Insts &insts) : insts(insts) {}
 
@@ -0,0 +1,390 @@
+#include "dbm.h"
+#include "threadPool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define DBM_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using namespace fdlang::analysis;
+
+namespace {
+
+using Value = DBM::Value;
+
+struct Kernels {
+    const char *name;
+    // dst[j] = min(dst[j], c + src[j]) for every finite src[j]
+    void (*relax)(Value *dst, const Value *src, Value c, size_t len);
+    // dst[j] = max(dst[j], src[j])
+    void (*max)(Value *dst, const Value *src, size_t len);
+    // a[j] <= b[j] for every j
+    bool (*leq)(const Value *a, const Value *b, size_t len);
+    // a[j] == b[j] for every j
+    bool (*eq)(const Value *a, const Value *b, size_t len);
+};
+
+void relaxScalar(Value *dst, const Value *src, Value c, size_t len) {
+    for (size_t j = 0; j < len; j++)
+        dst[j] = std::min(dst[j], DBM::add(c, src[j]));
+}
+
+void maxScalar(Value *dst, const Value *src, size_t len) {
+    for (size_t j = 0; j < len; j++)
+        dst[j] = std::max(dst[j], src[j]);
+}
+
+bool leqScalar(const Value *a, const Value *b, size_t len) {
+    for (size_t j = 0; j < len; j++)
+        if (a[j] > b[j])
+            return false;
+    return true;
+}
+
+bool eqScalar(const Value *a, const Value *b, size_t len) {
+    return std::memcmp(a, b, len * sizeof(Value)) == 0;
+}
+
+const Kernels scalarKernels = {"scalar", relaxScalar, maxScalar, leqScalar,
+                               eqScalar};
+
+#ifdef DBM_X86_KERNELS
+
+// `adds' saturates finite sums to [INT16_MIN, INF], the lower end is clamped
+// to -INF as `DBM::bound' does and lanes where `src' is INF are put back to INF
+
+__attribute__((target("sse4.1"))) void
+relaxSSE41(Value *dst, const Value *src, Value c, size_t len) {
+    const __m128i inf = _mm_set1_epi16(DBM::INF);
+    const __m128i ninf = _mm_set1_epi16(-DBM::INF);
+    const __m128i vc = _mm_set1_epi16(c);
+    for (size_t j = 0; j < len; j += 8) {
+        __m128i s = _mm_load_si128((const __m128i *)(src + j));
+        __m128i d = _mm_load_si128((const __m128i *)(dst + j));
+        __m128i sum = _mm_max_epi16(_mm_adds_epi16(s, vc), ninf);
+        sum = _mm_blendv_epi8(sum, inf, _mm_cmpeq_epi16(s, inf));
+        _mm_store_si128((__m128i *)(dst + j), _mm_min_epi16(d, sum));
+    }
+}
+
+__attribute__((target("sse4.1"))) void maxSSE41(Value *dst, const Value *src,
+                                                size_t len) {
+    for (size_t j = 0; j < len; j += 8) {
+        __m128i s = _mm_load_si128((const __m128i *)(src + j));
+        __m128i d = _mm_load_si128((const __m128i *)(dst + j));
+        _mm_store_si128((__m128i *)(dst + j), _mm_max_epi16(d, s));
+    }
+}
+
+__attribute__((target("sse4.1"))) bool leqSSE41(const Value *a, const Value *b,
+                                                size_t len) {
+    __m128i gt = _mm_setzero_si128();
+    for (size_t j = 0; j < len; j += 8) {
+        __m128i va = _mm_load_si128((const __m128i *)(a + j));
+        __m128i vb = _mm_load_si128((const __m128i *)(b + j));
+        gt = _mm_or_si128(gt, _mm_cmpgt_epi16(va, vb));
+    }
+    return _mm_testz_si128(gt, gt);
+}
+
+__attribute__((target("sse4.1"))) bool eqSSE41(const Value *a, const Value *b,
+                                               size_t len) {
+    // `len' is a whole number of 32-byte blocks
+    for (size_t j = 0; j < len; j += 16) {
+        __m128i ne0 = _mm_xor_si128(_mm_load_si128((const __m128i *)(a + j)),
+                                    _mm_load_si128((const __m128i *)(b + j)));
+        __m128i ne1 =
+            _mm_xor_si128(_mm_load_si128((const __m128i *)(a + j + 8)),
+                          _mm_load_si128((const __m128i *)(b + j + 8)));
+        __m128i ne = _mm_or_si128(ne0, ne1);
+        if (!_mm_testz_si128(ne, ne))
+            return false;
+    }
+    return true;
+}
+
+__attribute__((target("avx2"))) void relaxAVX2(Value *dst, const Value *src,
+                                               Value c, size_t len) {
+    const __m256i inf = _mm256_set1_epi16(DBM::INF);
+    const __m256i ninf = _mm256_set1_epi16(-DBM::INF);
+    const __m256i vc = _mm256_set1_epi16(c);
+    for (size_t j = 0; j < len; j += 16) {
+        __m256i s = _mm256_load_si256((const __m256i *)(src + j));
+        __m256i d = _mm256_load_si256((const __m256i *)(dst + j));
+        __m256i sum = _mm256_max_epi16(_mm256_adds_epi16(s, vc), ninf);
+        sum = _mm256_blendv_epi8(sum, inf, _mm256_cmpeq_epi16(s, inf));
+        _mm256_store_si256((__m256i *)(dst + j), _mm256_min_epi16(d, sum));
+    }
+}
+
+__attribute__((target("avx2"))) void maxAVX2(Value *dst, const Value *src,
+                                             size_t len) {
+    for (size_t j = 0; j < len; j += 16) {
+        __m256i s = _mm256_load_si256((const __m256i *)(src + j));
+        __m256i d = _mm256_load_si256((const __m256i *)(dst + j));
+        _mm256_store_si256((__m256i *)(dst + j), _mm256_max_epi16(d, s));
+    }
+}
+
+__attribute__((target("avx2"))) bool leqAVX2(const Value *a, const Value *b,
+                                             size_t len) {
+    __m256i gt = _mm256_setzero_si256();
+    for (size_t j = 0; j < len; j += 16) {
+        __m256i va = _mm256_load_si256((const __m256i *)(a + j));
+        __m256i vb = _mm256_load_si256((const __m256i *)(b + j));
+        gt = _mm256_or_si256(gt, _mm256_cmpgt_epi16(va, vb));
+    }
+    return _mm256_testz_si256(gt, gt);
+}
+
+__attribute__((target("avx2"))) bool eqAVX2(const Value *a, const Value *b,
+                                            size_t len) {
+    for (size_t j = 0; j < len; j += 16) {
+        __m256i ne = _mm256_xor_si256(
+            _mm256_load_si256((const __m256i *)(a + j)),
+            _mm256_load_si256((const __m256i *)(b + j)));
+        if (!_mm256_testz_si256(ne, ne))
+            return false;
+    }
+    return true;
+}
+
+const Kernels sse41Kernels = {"sse4.1", relaxSSE41, maxSSE41, leqSSE41,
+                              eqSSE41};
+const Kernels avx2Kernels = {"avx2", relaxAVX2, maxAVX2, leqAVX2, eqAVX2};
+
+#endif
+
+const Kernels *kernelsFor(DBMKernel kernel) {
+    switch (kernel) {
+    case DBMKernel::Scalar:
+        return &scalarKernels;
+#ifdef DBM_X86_KERNELS
+    case DBMKernel::SSE41:
+        return __builtin_cpu_supports("sse4.1") ? &sse41Kernels : nullptr;
+    case DBMKernel::AVX2:
+        return __builtin_cpu_supports("avx2") ? &avx2Kernels : nullptr;
+    case DBMKernel::Best:
+        // May run before the constructors of libgcc
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return &avx2Kernels;
+        if (__builtin_cpu_supports("sse4.1"))
+            return &sse41Kernels;
+        return &scalarKernels;
+#else
+    case DBMKernel::Best:
+        return &scalarKernels;
+#endif
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+const Kernels *active = kernelsFor(DBMKernel::Best);
+
+// Side of the tiles of the blocked closure: three tiles of 128 x 128 entries
+// take 96 KB and stay in L2. It is a whole number of vectors for every kernel.
+constexpr size_t TILE = 128;
+
+size_t blockedThreshold = DBM::BLOCKED_THRESHOLD;
+std::unique_ptr<ThreadPool> pool = std::make_unique<ThreadPool>(1);
+
+Value *allocate(size_t count) {
+    if (count == 0)
+        return nullptr;
+    return (Value *)::operator new(count * sizeof(Value),
+                                   std::align_val_t(DBM::ALIGNMENT));
+}
+
+void deallocate(Value *data) {
+    if (data)
+        ::operator delete(data, std::align_val_t(DBM::ALIGNMENT));
+}
+
+} // namespace
+
+DBM::Stats DBM::stats;
+
+DBM::DBM(size_t n, Value init) { assign(n, init); }
+
+DBM::DBM(const DBM &o) { *this = o; }
+
+DBM::DBM(DBM &&o) noexcept
+    : n(o.n), _stride(o._stride), _data(o._data), _capacity(o._capacity) {
+    o.n = o._stride = o._capacity = 0;
+    o._data = nullptr;
+}
+
+DBM &DBM::operator=(const DBM &o) {
+    if (this == &o)
+        return *this;
+    reserve(o.n * o._stride);
+    n = o.n;
+    _stride = o._stride;
+    if (_data)
+        std::memcpy(_data, o._data, n * _stride * sizeof(Value));
+    return *this;
+}
+
+DBM &DBM::operator=(DBM &&o) noexcept {
+    std::swap(n, o.n);
+    std::swap(_stride, o._stride);
+    std::swap(_data, o._data);
+    std::swap(_capacity, o._capacity);
+    return *this;
+}
+
+DBM::~DBM() { deallocate(_data); }
+
+void DBM::reserve(size_t count) {
+    if (count <= _capacity)
+        return;
+    deallocate(_data);
+    _data = nullptr, _capacity = 0;
+    _data = allocate(count);
+    _capacity = count;
+}
+
+void DBM::assign(size_t n, Value init) {
+    // A row is a whole number of 32-byte blocks, which is also a whole number
+    // of vectors for every kernel
+    size_t perBlock = ALIGNMENT / sizeof(Value);
+    size_t stride = (n + perBlock - 1) / perBlock * perBlock;
+    reserve(n * stride);
+    this->n = n;
+    _stride = stride;
+    if (_data)
+        std::fill(_data, _data + n * _stride, INF);
+    fill(init);
+}
+
+void DBM::fill(Value v) {
+    for (size_t i = 0; i < n; i++)
+        std::fill((*this)[i], (*this)[i] + n, v);
+}
+
+void DBM::close() {
+    if (pool->size() > 1 && n >= blockedThreshold) {
+        stats.blockedClosures++;
+        closeBlocked();
+        return;
+    }
+
+    stats.plainClosures++;
+    for (size_t k = 0; k < n; k++) {
+        const Value *rk = (*this)[k];
+        for (size_t i = 0; i < n; i++) {
+            Value ik = (*this)[i][k];
+            if (ik < INF)
+                active->relax((*this)[i], rk, ik, _stride);
+        }
+    }
+}
+
+void DBM::relaxRow(size_t i, size_t k, Value c) {
+    active->relax((*this)[i], (*this)[k], c, _stride);
+}
+
+void DBM::closeBlocked() {
+    size_t tiles = (n + TILE - 1) / TILE;
+
+    // Relax the tile (it, jt) through the variables of tile kt. Rows end at
+    // `n' and columns at the padded stride, so every row segment is a whole
+    // number of vectors.
+    auto relaxTile = [&](size_t kt, size_t it, size_t jt) {
+        size_t j0 = jt * TILE, len = std::min(_stride, j0 + TILE) - j0;
+        for (size_t k = kt * TILE; k < std::min(n, kt * TILE + TILE); k++) {
+            const Value *rk = (*this)[k] + j0;
+            for (size_t i = it * TILE; i < std::min(n, it * TILE + TILE);
+                 i++) {
+                Value ik = (*this)[i][k];
+                if (ik < INF)
+                    active->relax((*this)[i] + j0, rk, ik, len);
+            }
+        }
+    };
+
+    // Tile (it, kt) holds the bounds the round kt relaxes the rows of `it'
+    // by, so a round skips the row tiles whose column tile is INF. They stay
+    // INF since they are only relaxed through themselves. The matrices of the
+    // analyses have bounded variables only, so none of their tiles is INF.
+    auto isInf = [&](size_t it, size_t kt) {
+        for (size_t i = it * TILE; i < std::min(n, it * TILE + TILE); i++)
+            for (size_t k = kt * TILE; k < std::min(n, kt * TILE + TILE); k++)
+                if ((*this)[i][k] < INF)
+                    return false;
+        return true;
+    };
+    std::vector<size_t> live;
+    live.reserve(tiles);
+
+    for (size_t kt = 0; kt < tiles; kt++) {
+        relaxTile(kt, kt, kt);
+
+        live.clear();
+        for (size_t it = 0; it < tiles; it++)
+            if (it != kt && !isInf(it, kt))
+                live.push_back(it);
+
+        // The row and the column of the diagonal tile, which only read it
+        pool->parallelFor(tiles - 1 + live.size(), [&](size_t t) {
+            if (t < tiles - 1)
+                relaxTile(kt, kt, t < kt ? t : t + 1);
+            else
+                relaxTile(kt, live[t - (tiles - 1)], kt);
+        });
+
+        // The rest, which only read the row and the column
+        pool->parallelFor(live.size() * (tiles - 1), [&](size_t t) {
+            size_t it = live[t / (tiles - 1)], jt = t % (tiles - 1);
+            relaxTile(kt, it, jt < kt ? jt : jt + 1);
+        });
+    }
+}
+
+void DBM::relax(Value *dst, const Value *src, Value c, size_t len) {
+    active->relax(dst, src, c, len);
+}
+
+void DBM::maxWith(const DBM &o) {
+    active->max(_data, o._data, n * _stride);
+}
+
+bool DBM::leq(const DBM &o) const {
+    for (size_t i = 0; i < n; i++)
+        if (!active->leq((*this)[i], o[i], _stride))
+            return false;
+    return true;
+}
+
+bool DBM::eq(const DBM &o) const {
+    return active->eq(_data, o._data, n * _stride);
+}
+
+bool DBM::useKernel(DBMKernel kernel) {
+    const Kernels *k = kernelsFor(kernel);
+    if (!k)
+        return false;
+    active = k;
+    return true;
+}
+
+void DBM::useThreads(size_t threads, size_t minSize) {
+    blockedThreshold = minSize;
+    if (pool->size() != std::max<size_t>(threads, 1))
+        pool = std::make_unique<ThreadPool>(std::max<size_t>(threads, 1));
+}
+
+size_t DBM::threads() { return pool->size(); }
+
+size_t DBM::blockedSize() { return blockedThreshold; }
+
+const char *DBM::kernelName() { return active->name; }
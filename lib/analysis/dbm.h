@@ -0,0 +1,195 @@
+#ifndef ANALYSIS_DBM_H
+#define ANALYSIS_DBM_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace fdlang::analysis {
+
+/**
+ * Instruction sets the DBM kernels can be built for. `Best' picks the widest
+ * one supported by the running CPU.
+ */
+enum class DBMKernel { Scalar, SSE41, AVX2, Best };
+
+/**
+ * Square difference-bound matrix stored in a single aligned row-major buffer
+ *
+ * Every row is padded to a whole number of SIMD vectors and the padding is
+ * kept at INF, so the kernels always run over full vectors and the padding
+ * never takes part in a comparison.
+ *
+ * FDlang values live in [0, 255], so every finite bound fits in 16 bits. INF
+ * is the largest value and absorbs every addition, finite sums saturate to
+ * [-INF, INF].
+ */
+class DBM {
+public:
+    struct Stats {
+        // Runs of the plain triple loop
+        size_t plainClosures = 0;
+        // Runs of the closure by tiles
+        size_t blockedClosures = 0;
+    };
+
+    using Value = int16_t;
+    static constexpr Value INF = INT16_MAX;
+
+    /**
+     * @brief Clamp `c' to [-INF, INF]
+     */
+    static constexpr Value bound(long long c) {
+        return c >= INF ? INF : c <= -INF ? -INF : (Value)c;
+    }
+
+    /**
+     * @brief Saturating `a + b'
+     */
+    static constexpr Value add(Value a, Value b) {
+        if (a == INF || b == INF)
+            return INF;
+        return bound((long long)a + b);
+    }
+
+    // Alignment of the rows, in bytes
+    static constexpr size_t ALIGNMENT = 32;
+
+    // Matrices closed by tiles by default, see `useThreads'
+    static constexpr size_t BLOCKED_THRESHOLD = 512;
+
+private:
+    static Stats stats;
+
+    size_t n = 0;
+    size_t _stride = 0;
+    Value *_data = nullptr;
+
+    // Entries `_data' has room for, kept when the matrix shrinks
+    size_t _capacity = 0;
+
+    /**
+     * @brief Make room for `count' entries, dropping the old ones
+     */
+    void reserve(size_t count);
+
+    /**
+     * @brief Blocked Floyd-Warshall closure, see `close'
+     */
+    void closeBlocked();
+
+public:
+    DBM() = default;
+    DBM(size_t n, Value init);
+    DBM(const DBM &o);
+    DBM(DBM &&o) noexcept;
+    DBM &operator=(const DBM &o);
+    DBM &operator=(DBM &&o) noexcept;
+    ~DBM();
+
+    size_t size() const { return n; }
+
+    size_t stride() const { return _stride; }
+
+    Value *operator[](size_t i) { return _data + i * _stride; }
+
+    const Value *operator[](size_t i) const { return _data + i * _stride; }
+
+    /**
+     * @brief Turn `*this' into `n' x `n' with every entry `init', reusing the
+     * storage when it is large enough
+     */
+    void assign(size_t n, Value init);
+
+    /**
+     * @brief Set every entry (but not the padding) to `v'
+     */
+    void fill(Value v);
+
+    /**
+     * @brief Floyd-Warshall closure
+     *
+     * Once `useThreads' asks for several threads, large matrices are closed
+     * by square tiles, which stay in the cache. Every round closes the
+     * diagonal tile first, then its row and column, then the rest, and the
+     * tiles of the last two phases run in parallel, except the rows of tiles
+     * which are INF in the column of the diagonal tile. The result is the
+     * same as the one of the plain triple loop.
+     */
+    void close();
+
+    /**
+     * @brief `(*this)[i][j] = min((*this)[i][j], c + (*this)[k][j])' for all j
+     *
+     * Entries of row `k' that are INF are left out.
+     */
+    void relaxRow(size_t i, size_t k, Value c);
+
+    /**
+     * @brief `dst[j] = min(dst[j], c + src[j])' for every finite `src[j]'
+     *
+     * Both rows are aligned and `len' is a whole number of blocks, like the
+     * rows of a `DBM'.
+     */
+    static void relax(Value *dst, const Value *src, Value c, size_t len);
+
+    /**
+     * @brief Elementwise maximum with `o'
+     */
+    void maxWith(const DBM &o);
+
+    /**
+     * @brief Test if every entry of `*this' is less or equal than `o'
+     */
+    bool leq(const DBM &o) const;
+
+    /**
+     * @brief Test if every entry of `*this' is equal to `o'
+     */
+    bool eq(const DBM &o) const;
+
+    /**
+     * @brief Select the kernels used by every DBM
+     *
+     * Return false and keep the current kernels if `kernel' is not supported
+     * by the running CPU.
+     */
+    static bool useKernel(DBMKernel kernel);
+
+    /**
+     * @brief Get the name of the kernels in use
+     */
+    static const char *kernelName();
+
+    /**
+     * @brief Close matrices of at least `minSize' variables by tiles, on
+     * `threads' threads including the calling one
+     *
+     * On a single thread the tiles gain nothing over the plain loop, which
+     * streams whole rows through the SIMD kernels, so it is kept.
+     *
+     * `OctagonDomain' closes matrices of 2n x 2n, so from 256 variables on by
+     * default. `ZoneKind::Auto' keeps a zone dense when several threads are
+     * asked for and some of its components can reach `minSize' variables,
+     * which `ZoneDomain' then closes by tiles.
+     */
+    static void useThreads(size_t threads,
+                           size_t minSize = BLOCKED_THRESHOLD);
+
+    /**
+     * @brief Get the number of threads closing the large matrices
+     */
+    static size_t threads();
+
+    /**
+     * @brief Get the size from which matrices are closed by tiles
+     */
+    static size_t blockedSize();
+
+    static const Stats &getStats() { return stats; }
+
+    static void resetStats() { stats = Stats(); }
+};
+
+} // namespace fdlang::analysis
+
+#endif
@@ -0,0 +1,237 @@
+#include "defUseGraph.h"
+
+#include <algorithm>
+
+using namespace fdlang;
+using namespace fdlang::analysis;
+
+bool DefUseGraph::defines(const IR::Inst *inst) {
+    switch (inst->getInstType()) {
+    case IR::InstType::AssignInst:
+    case IR::InstType::InputInst:
+    case IR::InstType::AddInst:
+    case IR::InstType::SubInst:
+    case IR::InstType::IfInst:
+        return true;
+    default:
+        return false;
+    }
+}
+
+DefUseGraph::DefUseGraph(const IR::Insts &insts,
+                         const std::vector<std::array<size_t, 3>> &operands,
+                         size_t vars) {
+    size_t n = insts.size();
+
+    // Nodes of the CFG: the labels, then a node on every edge out of an
+    // `IfInst', which holds its filter, then the entry
+    std::vector<size_t> firstEdge(n, NONE);
+    std::vector<std::pair<size_t, size_t>> edgeOf;
+    for (auto inst : insts) {
+        if (inst->getInstType() != IR::InstType::IfInst)
+            continue;
+        firstEdge[inst->getLabel()] = n + edgeOf.size();
+        for (size_t i = 0; i < inst->getSuccessors().size(); i++)
+            edgeOf.emplace_back(inst->getLabel(), i);
+    }
+    size_t entry = n + edgeOf.size(), nodes = entry + 1;
+
+    std::vector<std::vector<size_t>> succ(nodes), pred(nodes);
+    auto edge = [&](size_t from, size_t to) {
+        succ[from].push_back(to);
+        pred[to].push_back(from);
+    };
+    predEdges.assign(n, {});
+    if (n > 0) {
+        edge(entry, 0);
+        predEdges[0].emplace_back(NONE, 0);
+    }
+    for (auto inst : insts) {
+        size_t label = inst->getLabel();
+        const auto &succs = inst->getSuccessors();
+        for (size_t i = 0; i < succs.size(); i++) {
+            size_t from = label;
+            if (firstEdge[label] != NONE)
+                edge(label, from = firstEdge[label] + i);
+            edge(from, succs[i]->getLabel());
+            predEdges[succs[i]->getLabel()].emplace_back(label, i);
+        }
+    }
+
+    // Reverse postorder from the entry
+    std::vector<size_t> rpo, rpoIndex(nodes, NONE);
+    std::vector<bool> visited(nodes, false);
+    std::vector<std::pair<size_t, size_t>> dfs = {{entry, 0}};
+    visited[entry] = true;
+    while (!dfs.empty()) {
+        size_t v = dfs.back().first, i = dfs.back().second++;
+        if (i == succ[v].size()) {
+            rpo.push_back(v);
+            dfs.pop_back();
+        } else if (!visited[succ[v][i]]) {
+            visited[succ[v][i]] = true;
+            dfs.emplace_back(succ[v][i], 0);
+        }
+    }
+    std::reverse(rpo.begin(), rpo.end());
+    for (size_t i = 0; i < rpo.size(); i++)
+        rpoIndex[rpo[i]] = i;
+
+    // Dominators, by the iterative algorithm of Cooper, Harvey and Kennedy
+    std::vector<size_t> idom(nodes, NONE);
+    idom[entry] = entry;
+    auto intersect = [&](size_t a, size_t b) {
+        while (a != b) {
+            while (rpoIndex[a] > rpoIndex[b])
+                a = idom[a];
+            while (rpoIndex[b] > rpoIndex[a])
+                b = idom[b];
+        }
+        return a;
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t b : rpo) {
+            if (b == entry)
+                continue;
+            size_t newIdom = NONE;
+            for (size_t p : pred[b])
+                if (idom[p] != NONE)
+                    newIdom = newIdom == NONE ? p : intersect(p, newIdom);
+            if (idom[b] != newIdom) {
+                idom[b] = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    // Dominance frontiers, only merges of several edges are in one
+    std::vector<std::vector<size_t>> frontier(nodes);
+    for (size_t b : rpo) {
+        if (pred[b].size() < 2)
+            continue;
+        for (size_t p : pred[b])
+            for (size_t r = p; idom[p] != NONE && r != idom[b]; r = idom[r])
+                frontier[r].push_back(b);
+    }
+
+    // Phis on the iterated frontiers of the definitions of each variable
+    std::vector<std::vector<size_t>> defSites(vars);
+    for (auto inst : insts) {
+        size_t label = inst->getLabel();
+        if (!defines(inst) || rpoIndex[label] == NONE)
+            continue;
+        if (firstEdge[label] == NONE)
+            defSites[operands[label][0]].push_back(label);
+        else
+            for (size_t i = 0; i < inst->getSuccessors().size(); i++)
+                defSites[operands[label][0]].push_back(firstEdge[label] + i);
+    }
+
+    for (size_t var = 0; var < vars; var++)
+        defs.push_back({DefKind::Entry, var});
+    defsAtLabel.assign(n, {});
+    std::vector<size_t> hasPhi(nodes, NONE), added(nodes, NONE);
+    for (size_t var = 0; var < vars; var++) {
+        std::vector<size_t> work = defSites[var];
+        for (size_t x : work)
+            added[x] = var;
+        while (!work.empty()) {
+            size_t x = work.back();
+            work.pop_back();
+            for (size_t y : frontier[x]) {
+                if (hasPhi[y] == var)
+                    continue;
+                hasPhi[y] = var;
+                defsAtLabel[y].push_back(defs.size());
+                defs.push_back({DefKind::Phi, var, y});
+                defs.back().args.assign(predEdges[y].size(), NONE);
+                if (added[y] != var) {
+                    added[y] = var;
+                    work.push_back(y);
+                }
+            }
+        }
+    }
+
+    // Renaming along the dominator tree, with the def of every variable on
+    // top of its stack
+    std::vector<std::vector<size_t>> children(nodes);
+    for (size_t b : rpo)
+        if (b != entry)
+            children[idom[b]].push_back(b);
+
+    std::vector<std::vector<size_t>> stacks(vars);
+    for (size_t var = 0; var < vars; var++)
+        stacks[var].push_back(var);
+    uses.assign(n, {NONE, NONE, NONE});
+
+    // Variables pushed by the nodes being visited, each node pops its own
+    std::vector<size_t> pushed;
+    auto define = [&](size_t var, size_t def) {
+        stacks[var].push_back(def);
+        pushed.push_back(var);
+    };
+
+    // (node, next child, size of `pushed' before the node)
+    std::vector<std::array<size_t, 3>> walk = {{entry, 0, 0}};
+    auto enter = [&](size_t b) {
+        if (b < n) {
+            for (size_t d : defsAtLabel[b])
+                define(defs[d].var, d);
+
+            IR::Inst *inst = insts[b];
+            for (size_t i = 0; i < inst->getOperandSize(); i++)
+                if (inst->getOperand(i)->isVariable())
+                    uses[b][i] = stacks[operands[b][i]].back();
+            if (defines(inst) && firstEdge[b] == NONE) {
+                Def def = {DefKind::Inst, operands[b][0], b};
+                def.args.assign(uses[b].begin(), uses[b].end());
+                def.args[0] = NONE;
+                defsAtLabel[b].push_back(defs.size());
+                define(def.var, defs.size());
+                defs.push_back(std::move(def));
+            }
+        } else if (b < entry) {
+            auto [label, i] = edgeOf[b - n];
+            size_t var = operands[label][0];
+            Def def = {DefKind::Filter, var, label, i};
+            def.args = {stacks[var].back()};
+            defsAtLabel[label].push_back(defs.size());
+            define(var, defs.size());
+            defs.push_back(std::move(def));
+        }
+
+        // Arguments of the phis of the successors, which come first
+        for (size_t s : succ[b]) {
+            if (s >= n)
+                continue;
+            size_t j = std::find(pred[s].begin(), pred[s].end(), b) -
+                       pred[s].begin();
+            for (size_t d : defsAtLabel[s]) {
+                if (defs[d].kind != DefKind::Phi)
+                    break;
+                defs[d].args[j] = stacks[defs[d].var].back();
+            }
+        }
+    };
+    enter(entry);
+    while (!walk.empty()) {
+        auto &[b, next, start] = walk.back();
+        if (next < children[b].size()) {
+            size_t c = children[b][next++];
+            size_t size = pushed.size();
+            enter(c);
+            walk.push_back({c, 0, size});
+            continue;
+        }
+        for (; pushed.size() > start; pushed.pop_back())
+            stacks[pushed.back()].pop_back();
+        walk.pop_back();
+    }
+
+    for (size_t d = 0; d < defs.size(); d++)
+        for (size_t arg : defs[d].args)
+            if (arg != NONE)
+                defs[arg].users.push_back(d);
+}
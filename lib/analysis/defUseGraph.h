@@ -0,0 +1,95 @@
+#ifndef ANALYSIS_DEFUSEGRAPH_H
+#define ANALYSIS_DEFUSEGRAPH_H
+
+#include "IR/IR.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace fdlang::analysis {
+
+/**
+ * Def-use chains of the variables of a program, in SSA form
+ *
+ * Every variable has a definition at the entry, every assignment defines its
+ * destination, and every edge out of an `IfInst' defines the tested variable
+ * again, as the guard filters it. Where several definitions of a variable
+ * meet, the label gets a phi, placed on the iterated dominance frontier of
+ * the definitions, so the size of the graph follows the definitions and the
+ * uses, not the number of variables times the number of labels.
+ */
+class DefUseGraph {
+public:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    enum class DefKind { Entry, Inst, Filter, Phi };
+
+    struct Def {
+        DefKind kind;
+        size_t var;
+        // Label of the instruction, of the `IfInst' of a filter, or of the
+        // merge of a phi, NONE for the entry
+        size_t label = NONE;
+        // Successor of the `IfInst' a filter is on
+        size_t succ = 0;
+        // Defs of the operands of an instruction, NONE for the constants and
+        // the destination. A filter has the def of the tested variable, and
+        // a phi the def coming from each of `preds(label)'
+        std::vector<size_t> args = {};
+        // Defs which have this one in their `args'
+        std::vector<size_t> users = {};
+    };
+
+private:
+    std::vector<Def> defs;
+
+    // label -> defs reaching the operands of the instruction
+    std::vector<std::array<size_t, 3>> uses;
+
+    // label -> phis, then the def of the instruction or the filters on the
+    // edges of an `IfInst'
+    std::vector<std::vector<size_t>> defsAtLabel;
+
+    // label -> edges into the label, as (label, successor index), with
+    // (NONE, 0) for the entry of label 0
+    std::vector<std::vector<std::pair<size_t, size_t>>> predEdges;
+
+public:
+    /**
+     * @brief Build the chains of `insts', whose operands have the variable
+     * ids `operands', in [0, vars)
+     */
+    DefUseGraph(const IR::Insts &insts,
+                const std::vector<std::array<size_t, 3>> &operands,
+                size_t vars);
+
+    /**
+     * @brief Test if `inst' defines its first operand, on every edge for an
+     * `IfInst'
+     */
+    static bool defines(const IR::Inst *inst);
+
+    const std::vector<Def> &getDefs() const { return defs; }
+
+    /**
+     * @brief Get the defs reaching the operands of the instruction at
+     * `label', NONE for the constants and the labels the entry cannot reach
+     */
+    const std::array<size_t, 3> &getUses(size_t label) const {
+        return uses[label];
+    }
+
+    const std::vector<size_t> &defsAt(size_t label) const {
+        return defsAtLabel[label];
+    }
+
+    const std::vector<std::pair<size_t, size_t>> &preds(size_t label) const {
+        return predEdges[label];
+    }
+};
+
+} // namespace fdlang::analysis
+#endif
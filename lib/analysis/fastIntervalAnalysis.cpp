@@ -0,0 +1,397 @@
+#include "fastIntervalAnalysis.h"
+#include "variableOrder.h"
+
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define INTERVAL_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+using namespace fdlang;
+using namespace fdlang::analysis;
+
+namespace {
+
+struct Kernels {
+    const char *name;
+    // lo[j] = min(lo[j], srcLo[j]), hi[j] = max(hi[j], srcHi[j]), return
+    // true if a byte changed
+    bool (*join)(uint8_t *lo, uint8_t *hi, const uint8_t *srcLo,
+                 const uint8_t *srcHi, size_t len);
+    // a[j] == b[j] for every j
+    bool (*eq)(const uint8_t *a, const uint8_t *b, size_t len);
+};
+
+bool joinScalar(uint8_t *lo, uint8_t *hi, const uint8_t *srcLo,
+                const uint8_t *srcHi, size_t len) {
+    bool changed = false;
+    for (size_t j = 0; j < len; j++) {
+        changed |= srcLo[j] < lo[j] || srcHi[j] > hi[j];
+        lo[j] = std::min(lo[j], srcLo[j]);
+        hi[j] = std::max(hi[j], srcHi[j]);
+    }
+    return changed;
+}
+
+bool eqScalar(const uint8_t *a, const uint8_t *b, size_t len) {
+    return std::memcmp(a, b, len) == 0;
+}
+
+const Kernels scalarKernels = {"scalar", joinScalar, eqScalar};
+
+#ifdef INTERVAL_X86_KERNELS
+
+__attribute__((target("sse4.1"))) bool
+joinSSE41(uint8_t *lo, uint8_t *hi, const uint8_t *srcLo, const uint8_t *srcHi,
+          size_t len) {
+    __m128i changed = _mm_setzero_si128();
+    for (size_t j = 0; j < len; j += 16) {
+        __m128i l = _mm_load_si128((const __m128i *)(lo + j));
+        __m128i h = _mm_load_si128((const __m128i *)(hi + j));
+        __m128i nl =
+            _mm_min_epu8(l, _mm_load_si128((const __m128i *)(srcLo + j)));
+        __m128i nh =
+            _mm_max_epu8(h, _mm_load_si128((const __m128i *)(srcHi + j)));
+        changed = _mm_or_si128(changed, _mm_or_si128(_mm_xor_si128(l, nl),
+                                                      _mm_xor_si128(h, nh)));
+        _mm_store_si128((__m128i *)(lo + j), nl);
+        _mm_store_si128((__m128i *)(hi + j), nh);
+    }
+    return !_mm_testz_si128(changed, changed);
+}
+
+__attribute__((target("sse4.1"))) bool eqSSE41(const uint8_t *a,
+                                               const uint8_t *b, size_t len) {
+    for (size_t j = 0; j < len; j += 16) {
+        __m128i ne = _mm_xor_si128(_mm_load_si128((const __m128i *)(a + j)),
+                                   _mm_load_si128((const __m128i *)(b + j)));
+        if (!_mm_testz_si128(ne, ne))
+            return false;
+    }
+    return true;
+}
+
+__attribute__((target("avx2"))) bool joinAVX2(uint8_t *lo, uint8_t *hi,
+                                              const uint8_t *srcLo,
+                                              const uint8_t *srcHi,
+                                              size_t len) {
+    __m256i changed = _mm256_setzero_si256();
+    for (size_t j = 0; j < len; j += 32) {
+        __m256i l = _mm256_load_si256((const __m256i *)(lo + j));
+        __m256i h = _mm256_load_si256((const __m256i *)(hi + j));
+        __m256i nl =
+            _mm256_min_epu8(l, _mm256_load_si256((const __m256i *)(srcLo + j)));
+        __m256i nh =
+            _mm256_max_epu8(h, _mm256_load_si256((const __m256i *)(srcHi + j)));
+        changed =
+            _mm256_or_si256(changed, _mm256_or_si256(_mm256_xor_si256(l, nl),
+                                                     _mm256_xor_si256(h, nh)));
+        _mm256_store_si256((__m256i *)(lo + j), nl);
+        _mm256_store_si256((__m256i *)(hi + j), nh);
+    }
+    return !_mm256_testz_si256(changed, changed);
+}
+
+__attribute__((target("avx2"))) bool eqAVX2(const uint8_t *a, const uint8_t *b,
+                                            size_t len) {
+    for (size_t j = 0; j < len; j += 32) {
+        __m256i eq =
+            _mm256_cmpeq_epi8(_mm256_load_si256((const __m256i *)(a + j)),
+                              _mm256_load_si256((const __m256i *)(b + j)));
+        if (_mm256_movemask_epi8(eq) != -1)
+            return false;
+    }
+    return true;
+}
+
+const Kernels sse41Kernels = {"sse4.1", joinSSE41, eqSSE41};
+const Kernels avx2Kernels = {"avx2", joinAVX2, eqAVX2};
+
+#endif
+
+const Kernels *kernelsFor(DBMKernel kernel) {
+    switch (kernel) {
+    case DBMKernel::Scalar:
+        return &scalarKernels;
+#ifdef INTERVAL_X86_KERNELS
+    case DBMKernel::SSE41:
+        return __builtin_cpu_supports("sse4.1") ? &sse41Kernels : nullptr;
+    case DBMKernel::AVX2:
+        return __builtin_cpu_supports("avx2") ? &avx2Kernels : nullptr;
+    case DBMKernel::Best:
+        // May run before the constructors of libgcc
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return &avx2Kernels;
+        if (__builtin_cpu_supports("sse4.1"))
+            return &sse41Kernels;
+        return &scalarKernels;
+#else
+    case DBMKernel::Best:
+        return &scalarKernels;
+#endif
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+const Kernels *active = kernelsFor(DBMKernel::Best);
+
+} // namespace
+
+bool FastIntervalAnalysis::transfer(const IR::Inst *inst, size_t succ,
+                                    const uint8_t *input, uint8_t *output) {
+    iterations++;
+    std::memcpy(output, input, 2 * chunks * CHUNK);
+
+    // Bounds of an operand, the constants of `+' and `-' are left unbounded
+    // and the results saturate to [0, 255] like FDlang does
+    const auto &ids = operands[inst->getLabel()];
+    auto value = [&](size_t i) -> std::pair<long long, long long> {
+        IR::Value *v = inst->getOperand(i);
+        if (v->isNumber())
+            return {v->getAsNumber(), v->getAsNumber()};
+        return {input[ids[i]], input[chunks * CHUNK + ids[i]]};
+    };
+    auto assign = [&](long long l, long long r) {
+        output[ids[0]] = std::clamp(l, 0ll, 255ll);
+        output[chunks * CHUNK + ids[0]] = std::clamp(r, 0ll, 255ll);
+    };
+
+    switch (inst->getInstType()) {
+    case IR::InstType::AssignInst: {
+        auto [l, r] = value(1);
+        assign(l, r);
+        break;
+    }
+    case IR::InstType::InputInst:
+        assign(0, 255);
+        break;
+    case IR::InstType::AddInst: {
+        auto [l1, r1] = value(1);
+        auto [l2, r2] = value(2);
+        assign(l1 + l2, r1 + r2);
+        break;
+    }
+    case IR::InstType::SubInst: {
+        auto [l1, r1] = value(1);
+        auto [l2, r2] = value(2);
+        assign(l1 - r2, r1 - l2);
+        break;
+    }
+    case IR::InstType::IfInst: {
+        // Values [cl, ch] of the guard go to the destination, the others
+        // fall through, where only the bounds of [l, r] can move
+        auto [l, r] = value(0);
+        long long c = inst->getOperand(1)->getAsNumber();
+        long long cl = 0, ch = 255;
+        switch (((const IR::IfInst *)inst)->getCmpOperator()) {
+        case IR::CmpOperator::EQ:
+            cl = ch = c;
+            break;
+        case IR::CmpOperator::GEQ:
+            cl = c;
+            break;
+        case IR::CmpOperator::GT:
+            cl = c + 1;
+            break;
+        case IR::CmpOperator::LEQ:
+            ch = c;
+            break;
+        case IR::CmpOperator::LT:
+            ch = c - 1;
+            break;
+        default:
+            break;
+        }
+        if (succ == 1) {
+            l = std::max(l, cl), r = std::min(r, ch);
+        } else {
+            bool below = cl <= l, above = ch >= r;
+            if (below)
+                l = std::max(l, ch + 1);
+            if (above)
+                r = std::min(r, cl - 1);
+        }
+        if (l > r)
+            return false;
+        assign(l, r);
+        break;
+    }
+    default:
+        break;
+    }
+    return true;
+}
+
+bool FastIntervalAnalysis::joinInto(const uint8_t *state, size_t label,
+                                    bool widen) {
+    size_t len = chunks * CHUNK;
+    if (!widen)
+        return active->join(lo(label), hi(label), state, state + len, len);
+
+    // Widening only happens at the loop heads, the bounds which moved are
+    // looked up one by one among the thresholds
+    bool changed = false;
+    for (size_t j = 0; j < len; j++) {
+        uint8_t &l = lo(label)[j], &r = hi(label)[j];
+        if (state[j] < l) {
+            auto it = std::upper_bound(thresholds.begin(), thresholds.end(),
+                                       (long long)state[j]);
+            l = it == thresholds.begin() ? 0 : std::max(*--it, 0ll);
+            changed = true;
+        }
+        if (state[len + j] > r) {
+            auto it = std::lower_bound(thresholds.begin(), thresholds.end(),
+                                       (long long)state[len + j]);
+            r = it == thresholds.end() ? 255 : std::min(*it, 255ll);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void FastIntervalAnalysis::run() {
+    // An empty program has no label to start from, nor any check
+    if (insts.empty())
+        return;
+
+    // Numbering the variables, and resolving the operands to their ids once
+    env = std::make_shared<const VarEnv>(collectVariables(insts));
+
+    resolveOperands(*env);
+
+    // Collecting the widening thresholds and the loop heads, which are the
+    // targets of backward edges
+    collectThresholds();
+    findLoopHeads();
+
+    // Initializing the states, every variable is [0, 0] at the entry and so
+    // is the padding, which then never changes
+    iterations = 0;
+    chunks = (env->size() + CHUNK - 1) / CHUNK;
+    size_t bytes = 2 * chunks * CHUNK;
+    std::vector<Chunk> initState(2 * chunks, Chunk{});
+    inputStates.assign(2 * chunks * insts.size(), Chunk{});
+    reached.assign(insts.size(), false);
+    reached[0] = true;
+
+    // Edges into each label, for the narrowing
+    std::vector<std::vector<std::pair<size_t, size_t>>> preds(insts.size());
+    for (auto inst : insts) {
+        const auto &succs = inst->getSuccessors();
+        for (size_t i = 0; i < succs.size(); i++)
+            preds[succs[i]->getLabel()].emplace_back(inst->getLabel(), i);
+    }
+
+    // Worklist algorithm over the edges of the CFG, a label is only visited
+    // again when the values reaching it grow
+    std::vector<bool> inQueue(insts.size(), false);
+    std::vector<size_t> joins(insts.size(), 0);
+    std::vector<size_t> q(insts.size());
+    size_t head = 0, queued = 0;
+    auto push = [&](size_t label) {
+        q[(head + queued++) % q.size()] = label;
+        inQueue[label] = true;
+    };
+    push(0);
+
+    std::vector<Chunk> outputBuffer(2 * chunks);
+    uint8_t *output = outputBuffer.data()->v;
+    while (queued > 0) {
+        size_t now = q[head];
+        head = (head + 1) % q.size(), queued--;
+        inQueue[now] = false;
+
+        IR::Inst *inst = insts[now];
+        const auto &succs = inst->getSuccessors();
+        for (size_t i = 0; i < succs.size(); i++) {
+            if (!transfer(inst, i, lo(now), output))
+                continue;
+
+            size_t succ = succs[i]->getLabel();
+            bool changed;
+            if (!reached[succ]) {
+                std::memcpy(lo(succ), output, bytes);
+                reached[succ] = changed = true;
+            } else {
+                bool widen =
+                    loopHeads[succ] && ++joins[succ] > WIDENING_DELAY;
+                changed = joinInto(output, succ, widen);
+            }
+            if (changed && !inQueue[succ])
+                push(succ);
+        }
+    }
+
+    // Narrowing, like `IntervalAnalysis': recomputing a label from its
+    // predecessors keeps the post-fixpoint, starting from the widened loop
+    // heads
+    std::vector<size_t> narrowed(insts.size(), 0);
+    for (size_t label = 0; label < insts.size(); label++)
+        if (loopHeads[label] && joins[label] > WIDENING_DELAY)
+            push(label);
+
+    std::vector<Chunk> stateBuffer(2 * chunks);
+    uint8_t *state = stateBuffer.data()->v;
+    while (queued > 0) {
+        size_t label = q[head];
+        head = (head + 1) % q.size(), queued--;
+        inQueue[label] = false;
+        if (narrowed[label]++ == NARROWING_ROUNDS)
+            continue;
+
+        bool any = label == 0;
+        std::memcpy(state, initState.data(), bytes);
+        for (auto [pred, i] : preds[label]) {
+            if (!reached[pred] || !transfer(insts[pred], i, lo(pred), output))
+                continue;
+            if (any)
+                active->join(state, state + bytes / 2, output,
+                             output + bytes / 2, bytes / 2);
+            else
+                std::memcpy(state, output, bytes);
+            any = true;
+        }
+        if (any == reached[label] &&
+            (!any || active->eq(state, lo(label), bytes)))
+            continue;
+
+        std::memcpy(lo(label), state, bytes);
+        reached[label] = any;
+        for (auto succ : insts[label]->getSuccessors())
+            if (!inQueue[succ->getLabel()])
+                push(succ->getLabel());
+    }
+
+    // Answering the queries
+    for (auto inst : insts) {
+        if (inst->getInstType() != IR::InstType::CheckIntervalInst)
+            continue;
+        IR::CheckIntervalInst *checkInst = (IR::CheckIntervalInst *)inst;
+        size_t label = checkInst->getLabel();
+        if (!reached[label]) {
+            results[checkInst] = ResultType::UNREACHABLE;
+            continue;
+        }
+
+        size_t id = operands[label][0];
+        results[checkInst] =
+            checkInst->getOperand(1)->getAsNumber() <= lo(label)[id] &&
+                    hi(label)[id] <= checkInst->getOperand(2)->getAsNumber()
+                ? ResultType::YES
+                : ResultType::NO;
+    }
+}
+
+bool FastIntervalAnalysis::useKernel(DBMKernel kernel) {
+    const Kernels *k = kernelsFor(kernel);
+    if (!k)
+        return false;
+    active = k;
+    return true;
+}
+
+const char *FastIntervalAnalysis::kernelName() { return active->name; }
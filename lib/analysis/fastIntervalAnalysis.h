@@ -0,0 +1,102 @@
+#ifndef ANALYSIS_FASTINTERVALANALYSIS_H
+#define ANALYSIS_FASTINTERVALANALYSIS_H
+
+#include "dataflowAnalysis.h"
+#include "dbm.h"
+#include "intervalAnalysis.h"
+#include "zoneTransfer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace fdlang::analysis {
+
+/**
+ * Interval analysis keeping a single convex range [lo, hi] per variable
+ *
+ * It is the cheapest tier of the analyses, meant for a quick first pass: it
+ * loses the holes `IntervalAnalysis' keeps, in exchange for states of two
+ * bytes per variable. A state stores the lower bounds of all variables, then
+ * their upper bounds, each padded to a whole number of chunks of 32 bytes,
+ * so the join is a byte minimum and maximum over 32 variables per AVX2
+ * instruction and the comparison of two states is one compare mask per
+ * chunk. Any number of variables is handled chunk by chunk.
+ */
+class FastIntervalAnalysis : public DataflowAnalysis {
+public:
+    // Variables per chunk of the states
+    static constexpr size_t CHUNK = 32;
+
+private:
+    struct alignas(CHUNK) Chunk {
+        uint8_t v[CHUNK];
+    };
+
+    std::map<IR::CheckIntervalInst *, ResultType> results;
+
+    // All variables, they are zero at the entry
+    std::shared_ptr<const VarEnv> env;
+
+    // Chunks of the lower bounds in a state, as many follow for the upper
+    // bounds
+    size_t chunks = 0;
+
+    // label -> values of the variables when the label is reached, meaningless
+    // for the labels not reached yet
+    std::vector<Chunk> inputStates;
+    std::vector<bool> reached;
+
+    // Transfers computed by the worklist and the narrowing
+    size_t iterations = 0;
+
+    uint8_t *lo(size_t label) { return inputStates[2 * chunks * label].v; }
+
+    uint8_t *hi(size_t label) { return lo(label) + chunks * CHUNK; }
+
+    /**
+     * @brief Compute in `output' the values after `inst' on the edge to its
+     * `succ'-th successor
+     *
+     * The first successor of an `IfInst' is the false branch. Return false if
+     * no value of `input' takes the edge.
+     */
+    bool transfer(const IR::Inst *inst, size_t succ, const uint8_t *input,
+                  uint8_t *output);
+
+    /**
+     * @brief Join `state' into the one of `label', widened with the
+     * thresholds if `widen', return true if it changed
+     */
+    bool joinInto(const uint8_t *state, size_t label, bool widen);
+
+public:
+    FastIntervalAnalysis(const IR::Insts &insts) : DataflowAnalysis(insts) {}
+
+    void dumpResult(std::ostream &out) override {
+        dumpResults(out, results);
+    }
+
+    void run() override;
+
+    size_t getIterations() const { return iterations; }
+
+    /**
+     * @brief Select the kernels used by every fast interval analysis
+     *
+     * Return false and keep the current kernels if `kernel' is not supported
+     * by the running CPU. The SSE4.1 kernels take 16 variables at a time.
+     */
+    static bool useKernel(DBMKernel kernel);
+
+    /**
+     * @brief Get the name of the kernels in use
+     */
+    static const char *kernelName();
+};
+
+} // namespace fdlang::analysis
+#endif
@@ -0,0 +1,404 @@
+#ifndef ANALYSIS_FIXEDZONEDOMAIN_H
+#define ANALYSIS_FIXEDZONEDOMAIN_H
+
+#include "IR/IR.h"
+#include "dbm.h"
+#include "zoneTransfer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fdlang::analysis {
+
+/**
+ * N x N difference-bound matrix held by value
+ *
+ * Every loop runs over the whole matrix, so the trip counts are known at
+ * compile time and the compiler unrolls and vectorizes them. The operations
+ * are constexpr, except that rows of whole `DBM' blocks are relaxed by the
+ * SIMD kernels of `DBM' at run time.
+ */
+template <size_t N> class FixedDBM {
+public:
+    using Value = DBM::Value;
+    static constexpr Value INF = DBM::INF;
+
+private:
+    static constexpr bool BLOCKED = N * sizeof(Value) % DBM::ALIGNMENT == 0;
+
+    struct alignas(DBM::ALIGNMENT) Row : std::array<Value, N> {};
+    std::array<Row, N> _data{};
+
+public:
+    constexpr FixedDBM() = default;
+
+    constexpr explicit FixedDBM(Value init) {
+        for (size_t i = 0; i < N; i++)
+            for (size_t j = 0; j < N; j++)
+                _data[i][j] = init;
+    }
+
+    constexpr std::array<Value, N> &operator[](size_t i) { return _data[i]; }
+
+    constexpr const std::array<Value, N> &operator[](size_t i) const {
+        return _data[i];
+    }
+
+    /**
+     * @brief `DBM::add' without branches, so that the loops vectorize
+     */
+    static constexpr Value add(Value a, Value b) {
+        int sum = std::max(std::min((int)a + b, (int)INF), -(int)INF);
+        return a == INF || b == INF ? INF : (Value)sum;
+    }
+
+    /**
+     * @brief Floyd-Warshall closure
+     *
+     * Return false if there is a negative cycle.
+     */
+    constexpr bool close() {
+        for (size_t k = 0; k < N; k++)
+            for (size_t i = 0; i < N; i++)
+                if (_data[i][k] < INF)
+                    relaxRow(i, k, _data[i][k]);
+        for (size_t i = 0; i < N; i++)
+            if (_data[i][i] < 0)
+                return false;
+        return true;
+    }
+
+    /**
+     * @brief `(*this)[i][j] = min((*this)[i][j], c + (*this)[k][j])' for all j
+     */
+    constexpr void relaxRow(size_t i, size_t k, Value c) {
+        if constexpr (BLOCKED) {
+            DBM::relax(_data[i].data(), _data[k].data(), c, N);
+            return;
+        }
+        for (size_t j = 0; j < N; j++)
+            _data[i][j] = std::min(_data[i][j], add(c, _data[k][j]));
+    }
+
+    /**
+     * @brief `(*this)[j][i] = min((*this)[j][i], (*this)[j][k] + c)' for all j
+     */
+    constexpr void relaxColumn(size_t i, size_t k, Value c) {
+        for (size_t j = 0; j < N; j++)
+            _data[j][i] = std::min(_data[j][i], add(_data[j][k], c));
+    }
+
+    /**
+     * @brief Elementwise maximum with `o'
+     */
+    constexpr void maxWith(const FixedDBM &o) {
+        for (size_t i = 0; i < N; i++)
+            for (size_t j = 0; j < N; j++)
+                _data[i][j] = std::max(_data[i][j], o._data[i][j]);
+    }
+
+    /**
+     * @brief Test if every entry of `*this' is less or equal than `o'
+     */
+    constexpr bool leq(const FixedDBM &o) const {
+        int greater = 0;
+        for (size_t i = 0; i < N; i++)
+            for (size_t j = 0; j < N; j++)
+                greater |= _data[i][j] > o._data[i][j];
+        return !greater;
+    }
+
+    /**
+     * @brief Test if every entry of `*this' is equal to `o'
+     */
+    constexpr bool eq(const FixedDBM &o) const {
+        int different = 0;
+        for (size_t i = 0; i < N; i++)
+            for (size_t j = 0; j < N; j++)
+                different |= _data[i][j] != o._data[i][j];
+        return !different;
+    }
+};
+
+/**
+ * Zone over at most N - 1 variables, without any heap allocation
+ *
+ * The matrix is the normal form of `ZoneDomain' and is kept closed after
+ * every operation. Ids from `env().size()' to N - 1 are padding that stays
+ * equal to the constant zero, which keeps the closure exact while every loop
+ * runs over all N ids.
+ */
+template <size_t N>
+class FixedZoneDomain : public ZoneTransfer<FixedZoneDomain<N>> {
+private:
+    using Value = DBM::Value;
+    static constexpr Value INF = DBM::INF;
+
+    std::shared_ptr<const VarEnv> _env;
+
+    // Same layout as `ZoneDomain::_dbm'
+    FixedDBM<N> _dbm;
+
+    bool _bottom = false;
+
+    void setBottom() {
+        _bottom = true;
+        _dbm = FixedDBM<N>();
+    }
+
+    /**
+     * @brief Drop every constraint on `k' except `0 <= k <= 255'
+     */
+    void havoc(size_t k) {
+        for (size_t i = 0; i < N; i++)
+            _dbm[i][k] = _dbm[k][i] = INF;
+        _dbm[k][k] = 0;
+        _dbm[k][0] = 0;
+        _dbm[0][k] = 255;
+    }
+
+    /**
+     * @brief Restore the normal form after tightening `_dbm[i][j]', see
+     * `ZoneDomain::closeEdge'
+     */
+    void closeEdge(size_t i, size_t j) {
+        Value c = _dbm[i][j];
+        if (DBM::add(c, _dbm[j][i]) < 0) {
+            setBottom();
+            return;
+        }
+        for (size_t a = 0; a < N; a++) {
+            Value ai = _dbm[a][i];
+            if (ai < INF)
+                _dbm.relaxRow(a, j, DBM::add(ai, c));
+        }
+    }
+
+    /**
+     * @brief Restore the normal form after rewriting the row and column of
+     * `v', see `ZoneDomain::closeVar'
+     *
+     * Since the rest is closed, the shortest paths from and to `v' are a
+     * single step out of the old row and column, so only their finite
+     * entries have to be followed.
+     */
+    void closeVar(size_t v) {
+        std::array<Value, N> row = _dbm[v], col{};
+        for (size_t k = 0; k < N; k++)
+            col[k] = _dbm[k][v];
+
+        for (size_t k = 0; k < N; k++) {
+            if (k == v)
+                continue;
+            if (row[k] < INF)
+                _dbm.relaxRow(v, k, row[k]);
+            if (col[k] < INF)
+                _dbm.relaxColumn(v, k, col[k]);
+        }
+
+        for (size_t k = 0; k < N; k++) {
+            if (DBM::add(_dbm[v][k], _dbm[k][v]) < 0) {
+                setBottom();
+                return;
+            }
+        }
+        _dbm[v][v] = 0;
+
+        for (size_t i = 0; i < N; i++) {
+            Value iv = _dbm[i][v];
+            if (i != v && iv < INF)
+                _dbm.relaxRow(i, v, iv);
+        }
+    }
+
+public:
+    /**
+     * @brief Construct a new Fixed Zone Domain
+     *
+     * @param env appeared variables, at most N with the constant zero
+     * @param isInitialization true for initialization(all zero) and false for
+     * bottom
+     */
+    FixedZoneDomain(std::shared_ptr<const VarEnv> env, bool isInitialization)
+        : _env(std::move(env)), _dbm(0) {
+        assert(_env->size() <= N);
+        if (!isInitialization)
+            setBottom();
+    }
+    FixedZoneDomain() = default;
+
+    const VarEnv &env() const { return *_env; }
+
+    void dump(std::ostream &out) const {
+        if (isEmpty()) {
+            out << "; Unreachable" << std::endl;
+            return;
+        }
+
+        size_t n = _env->size();
+        for (size_t i = 1; i < n; i++) {
+            IntervalDomain interval = projection(i);
+            out << "; " << _env->getVar(i) << " = [" << interval.l << ", "
+                << interval.r << "]" << std::endl;
+        }
+        for (size_t i = 1; i < n; i++) {
+            for (size_t j = 1; j < n; j++) {
+                if (i == j || _dbm[i][j] >= INF)
+                    continue;
+                out << "; " << _env->getVar(i) << " - " << _env->getVar(j)
+                    << " <= " << _dbm[i][j] << std::endl;
+            }
+        }
+    }
+
+    /**
+     * @brief Test if `*this' is bottom
+     */
+    bool isEmpty() const { return _bottom; }
+
+    /**
+     * @brief Test if `*this' is less or equal than `o' in partial order <=
+     */
+    bool leq(const FixedZoneDomain &o) const {
+        if (_bottom)
+            return true;
+        return !o._bottom && _dbm.leq(o._dbm);
+    }
+
+    /**
+     * @brief Test if `*this' is equal to `o'
+     */
+    bool eq(const FixedZoneDomain &o) const {
+        return _bottom == o._bottom && _dbm.eq(o._dbm);
+    }
+
+    /**
+     * @brief Get the projection of `*this' on the variable `x'
+     */
+    IntervalDomain projection(size_t x) const {
+        if (_bottom)
+            return IntervalDomain(INF, -INF);
+        return IntervalDomain(-_dbm[x][0], _dbm[0][x]);
+    }
+
+    /**
+     * @brief Join `o' into `*this'
+     */
+    void joinWith(const FixedZoneDomain &o) {
+        if (_bottom) {
+            *this = o;
+            return;
+        }
+        if (!o._bottom)
+            _dbm.maxWith(o._dbm);
+    }
+
+    /**
+     * @brief Widen `*this' with `o', see `ZoneDomain::widen'
+     */
+    void widenWith(const FixedZoneDomain &o,
+                   const std::vector<long long> &thresholds) {
+        if (_bottom) {
+            *this = o;
+            return;
+        }
+        if (o._bottom)
+            return;
+
+        FixedDBM<N> ret = _dbm;
+        ret.maxWith(o._dbm);
+        for (size_t v = 1; v < N; v++) {
+            if (ret[0][v] > _dbm[0][v])
+                ret[0][v] =
+                    DBM::bound(this->widenUpper(thresholds, ret[0][v]));
+            if (ret[v][0] > _dbm[v][0])
+                ret[v][0] =
+                    DBM::bound(-this->widenLower(thresholds, -ret[v][0]));
+        }
+        for (size_t i = 1; i < N; i++)
+            for (size_t j = 1; j < N; j++)
+                if (ret[i][j] > _dbm[i][j])
+                    ret[i][j] = INF;
+
+        // The bounds only grow, so the closure finds no negative cycle
+        _dbm = ret;
+        _dbm.close();
+    }
+
+    /**
+     * @brief Filter by guard `x - y <= c'
+     */
+    void filter(size_t x, size_t y, long long c) {
+        if (_bottom || DBM::bound(c) >= _dbm[y][x])
+            return;
+        _dbm[y][x] = DBM::bound(c);
+        closeEdge(y, x);
+    }
+
+    /**
+     * @brief Excute `x = y + c'
+     *
+     * It is `x = x + c' for y == x and `x = c' for y == 0.
+     */
+    void assign(size_t x, size_t y, long long c) {
+        if (_bottom)
+            return;
+
+        if (y == x) {
+            long long pc = c;
+            pc = std::min(pc, 255ll - _dbm[0][x]);
+            pc = std::max(pc, -(long long)_dbm[0][x]);
+            long long mc = c;
+            mc = std::min(mc, 255ll + _dbm[x][0]);
+            mc = std::max(mc, (long long)_dbm[x][0]);
+
+            // Same bounds as `ZoneDomain::assign'
+            _dbm[x][0] = DBM::add(_dbm[x][0], DBM::bound(-mc));
+            _dbm[0][x] = DBM::add(_dbm[0][x], DBM::bound(pc));
+            for (size_t j = 1; j < N; j++) {
+                if (j == x)
+                    continue;
+                if (pc == mc) {
+                    _dbm[x][j] = DBM::add(_dbm[x][j], DBM::bound(-pc));
+                    _dbm[j][x] = DBM::add(_dbm[j][x], DBM::bound(pc));
+                } else {
+                    this->shiftSaturated(_dbm[j][x], _dbm[x][j], c,
+                                         -_dbm[j][0], _dbm[0][j]);
+                }
+            }
+
+            // `pc' and `mc' differ when `x' saturates
+            if (pc != mc)
+                closeVar(x);
+            return;
+        }
+
+        havoc(x);
+        _dbm[y][x] = std::min(_dbm[y][x], DBM::bound(c));
+        _dbm[x][y] = std::min(_dbm[x][y], DBM::bound(-c));
+        closeVar(x);
+    }
+
+    /**
+     * @brief Excute `x = [l, r]'
+     */
+    void assignInterval(size_t x, long long l, long long r) {
+        l = std::max(l, 0ll);
+        r = std::min(r, 255ll);
+        if (_bottom)
+            return;
+
+        havoc(x);
+        _dbm[x][0] = DBM::bound(-l);
+        _dbm[0][x] = DBM::bound(r);
+        closeVar(x);
+    }
+};
+
+} // namespace fdlang::analysis
+
+#endif
@@ -1,254 +1,401 @@
 #include "intervalAnalysis.h"
+#include "variableOrder.h"
 
 #include <algorithm>
-#include <array>
-#include <queue>
 #include <vector>
 
 using namespace fdlang;
 using namespace fdlang::analysis;
 
-/**
- * Your code starts here
- */
+ValueSet IntervalAnalysis::condition(const IR::IfInst *inst) {
+    int c = inst->getOperand(1)->getAsNumber();
+    switch (inst->getCmpOperator()) {
+    case IR::CmpOperator::EQ:
+        return ValueSet(c, c);
+    case IR::CmpOperator::GEQ:
+        return ValueSet(c, ValueSet::MAX);
+    case IR::CmpOperator::GT:
+        return ValueSet(c + 1, ValueSet::MAX);
+    case IR::CmpOperator::LEQ:
+        return ValueSet(ValueSet::MIN, c);
+    case IR::CmpOperator::LT:
+        return ValueSet(ValueSet::MIN, c - 1);
+    default:
+        return ValueSet();
+    }
+}
 
-void IntervalAnalysis::init() {
-    for (auto inst : insts) {
-        auto type = inst->getInstType();
-        if (type == IR::InstType::AssignInst) {
-            IR::AssignInst *assignInst = (IR::AssignInst *)inst;
-            auto dest = assignInst->getOperand(0);
-            if (!dest->isVariable()) {
-                continue;
-            }
-            vars.emplace(dest->getAsVariable());
-            auto src = assignInst->getOperand(1);
-            if (src->isVariable()) {
-                vars.emplace(src->getAsVariable());
-            }
+template <typename Values>
+ValueSet IntervalAnalysis::evaluate(const IR::Inst *inst, size_t succ,
+                                    Values values) {
+    // Sema leaves the constants of `+' and `-' unbounded, they saturate
+    // like the values they are added to
+    auto value = [&](size_t i) {
+        IR::Value *v = inst->getOperand(i);
+        if (v->isNumber()) {
+            int c = std::min<long long>(v->getAsNumber(), ValueSet::MAX);
+            return ValueSet(c, c);
         }
-        if (type == IR::InstType::InputInst) {
-            IR::InputInst *inputInst = (IR::InputInst *)inst;
-            auto dest = inputInst->getOperand(0);
-            if (!dest->isVariable()) {
-                continue;
-            }
-            vars.emplace(dest->getAsVariable());
-        }
-        if (type == IR::InstType::AddInst) {
-            IR::AddInst *addInst = (IR::AddInst *)inst;
-            auto dest = addInst->getOperand(0);
-            if (!dest->isVariable()) {
+        return ValueSet(values(i));
+    };
+
+    switch (inst->getInstType()) {
+    case IR::InstType::AssignInst:
+        return value(1);
+    case IR::InstType::InputInst:
+        return ValueSet(ValueSet::MIN, ValueSet::MAX);
+    case IR::InstType::AddInst:
+        return value(1).add(value(2));
+    case IR::InstType::SubInst: {
+        // `c - y' with c > MAX is `MAX - y' shifted up by the excess
+        IR::Value *operand1 = inst->getOperand(1);
+        long long excess =
+            operand1->isNumber()
+                ? std::max(operand1->getAsNumber() - ValueSet::MAX, 0ll)
+                : 0;
+        return value(1).sub(value(2)).add(
+            std::min<long long>(excess, ValueSet::MAX + 1));
+    }
+    case IR::InstType::IfInst: {
+        // Values of the guard go to the destination, the others fall through
+        ValueSet x = value(0);
+        ValueSet passed = condition((const IR::IfInst *)inst);
+        if (succ == 0)
+            x.remove(passed);
+        else
+            x.meetWith(passed);
+        return x;
+    }
+    default:
+        return ValueSet();
+    }
+}
+
+bool IntervalAnalysis::transfer(const IR::Inst *inst, size_t succ,
+                                const VarRange &input, VarRange &output) {
+    iterations++;
+    output = input;
+    if (!DefUseGraph::defines(inst))
+        return true;
+
+    const auto &ids = operands[inst->getLabel()];
+    ValueSet x = evaluate(inst, succ,
+                          [&](size_t i) { return input.getVar(ids[i]); });
+    if (x.isEmpty())
+        return false;
+    output.insertVar(ids[0], x);
+    return true;
+}
+
+void IntervalAnalysis::run() {
+    // An empty program has no label to start from, nor any check
+    if (insts.empty())
+        return;
+
+    // Numbering the variables, and resolving the operands to their ids once
+    env = std::make_shared<const VarEnv>(collectVariables(insts));
+
+    resolveOperands(*env);
+
+    // Collecting the widening thresholds and the loop heads, which are the
+    // targets of backward edges
+    collectThresholds();
+    findLoopHeads();
+
+    iterations = 0;
+    reached.assign(insts.size(), false);
+    if (mode == Mode::Sparse) {
+        inputStates.clear();
+        runSparse();
+        return;
+    }
+
+    // Initializing the states, every variable is zero at the entry
+    pool = std::make_unique<VarRangePool>(env->size());
+    VarRange initState(*pool, ValueSet(0, 0));
+    inputStates.assign(insts.size(), VarRange());
+    inputStates[0] = initState;
+    reached[0] = true;
+
+    // Edges into each label, for the narrowing
+    std::vector<std::vector<std::pair<size_t, size_t>>> preds(insts.size());
+    for (auto inst : insts) {
+        const auto &succs = inst->getSuccessors();
+        for (size_t i = 0; i < succs.size(); i++)
+            preds[succs[i]->getLabel()].emplace_back(inst->getLabel(), i);
+    }
+
+    // Worklist algorithm over the edges of the CFG, a label is only visited
+    // again when the values reaching it grow
+    std::vector<bool> inQueue(insts.size(), false);
+    std::vector<size_t> joins(insts.size(), 0);
+    std::vector<size_t> q(insts.size());
+    size_t head = 0, queued = 0;
+    auto push = [&](size_t label) {
+        q[(head + queued++) % q.size()] = label;
+        inQueue[label] = true;
+    };
+    push(0);
+
+    VarRange output;
+    while (queued > 0) {
+        size_t now = q[head];
+        head = (head + 1) % q.size(), queued--;
+        inQueue[now] = false;
+
+        IR::Inst *inst = insts[now];
+        const auto &succs = inst->getSuccessors();
+        for (size_t i = 0; i < succs.size(); i++) {
+            if (!transfer(inst, i, inputStates[now], output))
                 continue;
+
+            size_t succ = succs[i]->getLabel();
+            bool changed;
+            if (!reached[succ]) {
+                inputStates[succ] = output;
+                reached[succ] = changed = true;
+            } else if (loopHeads[succ] && ++joins[succ] > WIDENING_DELAY) {
+                changed = inputStates[succ].range_widen(output, thresholds);
+            } else {
+                changed = inputStates[succ].range_union(output);
             }
-            vars.emplace(dest->getAsVariable());
-            auto op1 = addInst->getOperand(1);
-            if (op1->isVariable()) {
-                vars.emplace(op1->getAsVariable());
-            }
-            auto op2 = addInst->getOperand(2);
-            if (op2->isVariable()) {
-                vars.emplace(op2->getAsVariable());
-            }
+            if (changed && !inQueue[succ])
+                push(succ);
         }
-        if (type == IR::InstType::SubInst) {
-            IR::SubInst *subInst = (IR::SubInst *)inst;
-            auto dest = subInst->getOperand(0);
-            if (!dest->isVariable()) {
+    }
+
+    // Narrowing: the widened states are a post-fixpoint, and recomputing any
+    // label from its predecessors keeps it one, so it can only make the
+    // states smaller and stays sound. It starts from the widened loop heads
+    // and goes on to the successors of the labels which shrink, each label
+    // being recomputed at most `narrowingRounds' times.
+    std::vector<size_t> narrowed(insts.size(), 0);
+    for (size_t label = 0; label < insts.size(); label++)
+        if (loopHeads[label] && joins[label] > WIDENING_DELAY)
+            push(label);
+
+    VarRange state;
+    while (queued > 0) {
+        size_t label = q[head];
+        head = (head + 1) % q.size(), queued--;
+        inQueue[label] = false;
+        if (narrowed[label]++ == narrowingRounds)
+            continue;
+
+        bool any = label == 0;
+        state = initState;
+        for (auto [pred, i] : preds[label]) {
+            if (!reached[pred] ||
+                !transfer(insts[pred], i, inputStates[pred], output))
                 continue;
-            }
-            vars.emplace(dest->getAsVariable());
-            auto op1 = subInst->getOperand(1);
-            if (op1->isVariable()) {
-                vars.emplace(op1->getAsVariable());
-            }
-            auto op2 = subInst->getOperand(2);
-            if (op2->isVariable()) {
-                vars.emplace(op2->getAsVariable());
-            }
+            if (any)
+                state.range_union(output);
+            else
+                state = output;
+            any = true;
         }
-        if (type == IR::InstType::GotoInst) {
-            IR::GotoInst *gotoInst = (IR::GotoInst *)inst;
-            targetToJump[gotoInst->getDestInst()->getLabel()] = gotoInst->getLabel();
-            BranchInfo* bInfo = new BranchInfo();
-            branchInfos[gotoInst->getLabel()] = bInfo;
+        if (any == reached[label] &&
+            (!any || state.range_equal(inputStates[label])))
+            continue;
+
+        inputStates[label] = state;
+        reached[label] = any;
+        for (auto succ : insts[label]->getSuccessors())
+            if (!inQueue[succ->getLabel()])
+                push(succ->getLabel());
+    }
+
+    answer([&](size_t label) {
+        return inputStates[label].getVar(operands[label][0]);
+    });
+}
+
+void IntervalAnalysis::runSparse() {
+    DefUseGraph graph(insts, operands, env->size());
+    const auto &defs = graph.getDefs();
+    using DefKind = DefUseGraph::DefKind;
+
+    // Values of each def, the variables are zero at the entry
+    std::vector<ValueSet> values(defs.size());
+    std::vector<std::array<size_t, 2>> filters(
+        insts.size(), {DefUseGraph::NONE, DefUseGraph::NONE});
+    for (size_t d = 0; d < defs.size(); d++) {
+        if (defs[d].kind == DefKind::Entry)
+            values[d] = ValueSet(0, 0);
+        if (defs[d].kind == DefKind::Filter)
+            filters[defs[d].label][defs[d].succ] = d;
+    }
+
+    // An edge is taken once its source is reached and, out of an `IfInst',
+    // once some value passes its filter
+    auto taken = [&](size_t label, size_t i) {
+        if (label == DefUseGraph::NONE)
+            return true;
+        size_t filter = filters[label][i];
+        return reached[label] &&
+               (filter == DefUseGraph::NONE || !values[filter].isEmpty());
+    };
+
+    // A def is computed from the defs it uses, a phi from the ones on the
+    // edges taken
+    auto compute = [&](size_t d) {
+        iterations++;
+        const auto &def = defs[d];
+        if (def.kind != DefKind::Phi)
+            return evaluate(insts[def.label], def.succ,
+                            [&](size_t i) { return values[def.args[i]]; });
+
+        ValueSet v;
+        const auto &preds = graph.preds(def.label);
+        for (size_t j = 0; j < preds.size(); j++)
+            if (def.args[j] != DefUseGraph::NONE &&
+                taken(preds[j].first, preds[j].second))
+                v.joinWith(values[def.args[j]]);
+        return v;
+    };
+
+    // Worklist of the defs whose arguments changed, a def is only computed
+    // once its label is reached. Reaching a label computes its defs, and
+    // the phis of a label reached again see the new edge.
+    std::vector<bool> inQueue(defs.size(), false);
+    std::vector<size_t> evaluations(defs.size(), 0);
+    std::vector<size_t> q(defs.size()), toReach;
+    size_t head = 0, queued = 0;
+    auto push = [&](size_t d) {
+        if (inQueue[d])
+            return;
+        q[(head + queued++) % q.size()] = d;
+        inQueue[d] = true;
+    };
+    auto pop = [&]() {
+        size_t d = q[head];
+        head = (head + 1) % q.size(), queued--;
+        inQueue[d] = false;
+        return d;
+    };
+    auto takeEdge = [&](size_t label, size_t i) {
+        size_t succ = insts[label]->getSuccessors()[i]->getLabel();
+        if (!reached[succ]) {
+            reached[succ] = true;
+            toReach.push_back(succ);
+            return;
         }
-        if (type == IR::InstType::IfInst) {
-            IR::IfInst *ifInst = (IR::IfInst *)inst;
-            targetToJump[ifInst->getDestInst()->getLabel()] = ifInst->getLabel();
-            std::string op1 = ifInst->getOperand(0)->getAsVariable();
-            int op2 = ifInst->getOperand(1)->getAsNumber();
-            int s, e;
-            switch (ifInst->getCmpOperator())
-            {
-            case fdlang::IR::CmpOperator::EQ:
-                s = op2;
-                e = op2;
-                break;
-            case fdlang::IR::CmpOperator::GEQ:
-                s = op2;
-                e = 255;
-                break;
-            case fdlang::IR::CmpOperator::GT:
-                s = op2 + 1;
-                e = 255;
+        for (size_t d : graph.defsAt(succ)) {
+            if (defs[d].kind != DefKind::Phi)
                 break;
-            case fdlang::IR::CmpOperator::LEQ:
-                s = 0;
-                e = op2;
-                break;
-            case fdlang::IR::CmpOperator::LT:
-                s = 0;
-                e = op2 - 1;
-                break;
-            default:
-                break;
-            }
-            BranchInfo* bInfo = new BranchInfo(op1, s, e);
-            branchInfos[ifInst->getLabel()] = bInfo;
-            vars.emplace(op1);
+            push(d);
         }
-        if (type == IR::InstType::CheckIntervalInst) {
-            IR::CheckIntervalInst *checkInst = (IR::CheckIntervalInst *)inst;
-            int l = checkInst->getOperand(1)->getAsNumber();
-            int r = checkInst->getOperand(2)->getAsNumber();
-            CheckInfo *cInfo = new CheckInfo(checkInst, l, r);
-            checkInfos[checkInst->getLabel()] = cInfo;
+    };
+
+    reached[0] = true;
+    toReach.push_back(0);
+    while (!toReach.empty() || queued > 0) {
+        if (!toReach.empty()) {
+            size_t label = toReach.back();
+            toReach.pop_back();
+            for (size_t d : graph.defsAt(label))
+                push(d);
+            if (filters[label][0] == DefUseGraph::NONE)
+                for (size_t i = 0; i < insts[label]->getSuccessors().size();
+                     i++)
+                    takeEdge(label, i);
+            continue;
         }
-    }
-}
 
-void IntervalAnalysis::iter() {
-    bool changed = true;
-    while (changed)
-    {
-    changed = false;
-    for (auto& v : vars) {
-        currRange.insertVar(v, Range(0, 0));
+        size_t d = pop();
+        const auto &def = defs[d];
+        if (!reached[def.label])
+            continue;
+        ValueSet v = compute(d);
+        bool wasEmpty = values[d].isEmpty();
+        bool changed = def.kind == DefKind::Phi && loopHeads[def.label] &&
+                               ++evaluations[d] > WIDENING_DELAY
+                           ? values[d].widenWith(v, thresholds)
+                           : values[d].joinWith(v);
+        if (!changed)
+            continue;
+        for (size_t user : def.users)
+            push(user);
+        if (def.kind == DefKind::Filter && wasEmpty)
+            takeEdge(def.label, def.succ);
     }
-    for (auto inst : insts)
-    {
-        auto type = inst->getInstType();
-        if (type == IR::InstType::AssignInst) {
-            IR::AssignInst *assignInst = (IR::AssignInst *)inst;
-            auto dest = assignInst->getOperand(0);
-            if (!dest->isVariable()) {
+
+    // Narrowing, like the dense one: recomputing a def from its arguments
+    // keeps the post-fixpoint, starting from the widened phis, each def being
+    // recomputed at most `narrowingRounds' times
+    std::vector<size_t> narrowed(defs.size(), 0);
+    for (size_t d = 0; d < defs.size(); d++)
+        if (evaluations[d] > WIDENING_DELAY)
+            push(d);
+    while (true) {
+        while (queued > 0) {
+            size_t d = pop();
+            if (!reached[defs[d].label] || narrowed[d]++ == narrowingRounds)
                 continue;
-            }
-            auto src = assignInst->getOperand(1);
-            if (src->isNumber()) {
-                auto value = src->getAsNumber();
-                currRange.insertVar(dest->getAsVariable(), Range(value, value));
-            }
-            if (src->isVariable()) {
-                auto value = src->getAsVariable();
-                currRange.insertVar(dest->getAsVariable(), currRange.getVar(value));
-            }
-        }
-        if (type == IR::InstType::InputInst) {
-            IR::InputInst *inputInst = (IR::InputInst *)inst;
-            auto dest = inputInst->getOperand(0);
-            if (!dest->isVariable()) {
+            ValueSet v = compute(d);
+            if (v == values[d])
                 continue;
-            }
-            currRange.insertVar(dest->getAsVariable(), Range(0, 255));
+            values[d] = v;
+            for (size_t user : defs[d].users)
+                push(user);
         }
-        if (type == IR::InstType::AddInst) {
-            IR::AddInst *addInst = (IR::AddInst *)inst;
-            auto dest = addInst->getOperand(0);
-            if (!dest->isVariable()) {
-                continue;
-            }
-            auto op1 = addInst->getOperand(1);
-            auto op2 = addInst->getOperand(2);
-            Range op1R, op2R;
-            if (op1->isNumber()) {
-                op1R = Range(op1->getAsNumber(), op1->getAsNumber());
-            }
-            if (op1->isVariable()) {
-                op1R = currRange.getVar(op1->getAsVariable());
-            }
-            if (op2->isNumber()) {
-                op2R = Range(op2->getAsNumber(), op2->getAsNumber());
-            }
-            if (op2->isVariable()) {
-                op2R = currRange.getVar(op2->getAsVariable());
+
+        // As the dense narrowing does, the labels are reached again through
+        // the narrowed filters. Labels only get lost, and the phis after a
+        // lost edge are recomputed without it
+        std::vector<bool> live(insts.size(), false);
+        live[0] = true;
+        toReach.assign(1, 0);
+        while (!toReach.empty()) {
+            size_t label = toReach.back();
+            toReach.pop_back();
+            for (size_t i = 0; i < insts[label]->getSuccessors().size(); i++) {
+                size_t succ = insts[label]->getSuccessors()[i]->getLabel();
+                size_t filter = filters[label][i];
+                if (live[succ] || (filters[label][0] != DefUseGraph::NONE &&
+                                   (filter == DefUseGraph::NONE ||
+                                    values[filter].isEmpty())))
+                    continue;
+                live[succ] = true;
+                toReach.push_back(succ);
             }
-            op1R.range_add(op2R);
-            currRange.insertVar(dest->getAsVariable(), op1R);
         }
-        if (type == IR::InstType::SubInst) {
-            IR::SubInst *subInst = (IR::SubInst *)inst;
-            auto dest = subInst->getOperand(0);
-            if (!dest->isVariable()) {
+        if (live == reached)
+            break;
+
+        for (size_t label = 0; label < insts.size(); label++) {
+            if (!reached[label] || live[label])
                 continue;
-            }
-            auto op1 = subInst->getOperand(1);
-            auto op2 = subInst->getOperand(2);
-            Range op1R, op2R;
-            if (op1->isNumber()) {
-                op1R = Range(op1->getAsNumber(), op1->getAsNumber());
-            }
-            if (op1->isVariable()) {
-                op1R = currRange.getVar(op1->getAsVariable());
-            }
-            if (op2->isNumber()) {
-                op2R = Range(op2->getAsNumber(), op2->getAsNumber());
-            }
-            if (op2->isVariable()) {
-                op2R = currRange.getVar(op2->getAsVariable());
-            }
-            op1R.range_minus(op2R);
-            currRange.insertVar(dest->getAsVariable(), op1R);
-        }
-        if (type == IR::InstType::GotoInst) {
-            IR::GotoInst *gotoInst = (IR::GotoInst *)inst;
-            auto bInfo = branchInfos[gotoInst->getLabel()];
-            changed |= bInfo->setGotoRange(currRange);
-            if (gotoInst->getDestInst()->getLabel() > gotoInst->getLabel()) {
-                // Only jump forward needs a new iteration
-                changed = false;
-            }
-        }
-        if (type == IR::InstType::IfInst) {
-            IR::IfInst *ifInst = (IR::IfInst *)inst;
-            auto bInfo = branchInfos[ifInst->getLabel()];
-            changed |= bInfo->setIfRange(currRange);
-            if (ifInst->getDestInst()->getLabel() > ifInst->getLabel()) {
-                // Only jump forward needs a new iteration
-                changed = false;
-            }
-        }
-        if (type == IR::InstType::LabelInst) {
-            IR::LabelInst *labelInst = (IR::LabelInst *)inst;
-            auto jumpRange = branchInfos[targetToJump[labelInst->getLabel()]]->getJumpRange();
-            currRange.range_union(jumpRange);
+            for (auto succ : insts[label]->getSuccessors())
+                for (size_t d : graph.defsAt(succ->getLabel())) {
+                    if (defs[d].kind != DefKind::Phi)
+                        break;
+                    narrowed[d] = 0;
+                    push(d);
+                }
         }
-        if (type == IR::InstType::CheckIntervalInst) {
-            IR::CheckIntervalInst *checkInst = (IR::CheckIntervalInst *)inst;
-            auto cInfo = checkInfos[checkInst->getLabel()];
-            cInfo->updateRealRange(currRange);
-        }
-    }
+        reached = live;
     }
-}
 
-void IntervalAnalysis::done() {
-    for (auto& cInfo : checkInfos) {
-        results[cInfo.second->getInst()] = cInfo.second->getResultType();
-    }
-    for (auto& bInfo : branchInfos) {
-        delete bInfo.second;
-    }
-    branchInfos.clear();
-    for (auto& cInfo : checkInfos) {
-        delete cInfo.second;
-    }
-    checkInfos.clear();
+    answer([&](size_t label) { return values[graph.getUses(label)[0]]; });
 }
 
-void IntervalAnalysis::run() {
-    init();
-    iter();
-    done();
+void IntervalAnalysis::answer(
+    const std::function<ValueSet(size_t label)> &checked) {
+    for (auto inst : insts) {
+        if (inst->getInstType() != IR::InstType::CheckIntervalInst)
+            continue;
+        IR::CheckIntervalInst *checkInst = (IR::CheckIntervalInst *)inst;
+        size_t label = checkInst->getLabel();
+        if (!reached[label]) {
+            results[checkInst] = ResultType::UNREACHABLE;
+            continue;
+        }
+
+        ValueSet expected(checkInst->getOperand(1)->getAsNumber(),
+                          checkInst->getOperand(2)->getAsNumber());
+        results[checkInst] = checked(label).subsetOf(expected)
+                                 ? ResultType::YES
+                                 : ResultType::NO;
+    }
 }
@@ -44,10 +44,89 @@ void NaiveModelChecker::evaluate(Stmts *node, Envs &envs) {
 }
 
 bool NaiveModelChecker::evaluate(Cond *node, Env &env) {
-    std::string variable = node->leftOperand.lexeme;
+    return evaluate(node->leftOperand, node->op, node->rightOperand, env);
+}
+
+void NaiveModelChecker::evaluate(UnaryAssignStmt *node, Envs &envs) {
+    assign(node->variable, node->operand, envs);
+}
+
+void NaiveModelChecker::evaluate(BinaryAssignStmt *node, Envs &envs) {
+    assign(node->variable, node->leftOperand, node->op, node->rightOperand,
+           envs);
+}
+
+void NaiveModelChecker::evaluate(IfStmt *node, Envs &envs) {
+    Cond *cond = (Cond *)node->cond;
+    branch(
+        cond->leftOperand, cond->op, cond->rightOperand,
+        [&](Envs &inner) { evaluate((Stmts *)node->trueBody, inner); },
+        [&](Envs &inner) { evaluate((Stmts *)node->falseBody, inner); }, envs);
+}
+
+void NaiveModelChecker::evaluate(WhileStmt *node, Envs &envs) {
+    Cond *cond = (Cond *)node->cond;
+    loop(
+        cond->leftOperand, cond->op, cond->rightOperand,
+        [&](Envs &inner) { evaluate((Stmts *)node->body, inner); }, envs);
+}
+
+void NaiveModelChecker::evaluate(CheckStmt *node, Envs &envs) {
+    record(node->label, node->params[0], envs);
+}
+
+void NaiveModelChecker::evaluate(NopStmt *node, Envs &envs) {}
+
+void NaiveModelChecker::evaluate(const FlatAST &ast, FlatAST::Index node,
+                                 Envs &envs) {
+    const Token *tokens = ast.getTokens(node);
+    switch (ast[node].type) {
+    case ASTNodeType::STMTS:
+        for (FlatAST::Index child = node + 1; child < ast[node].end;
+             child = ast[child].end)
+            evaluate(ast, child, envs);
+        break;
+    case ASTNodeType::UNARY_ASSIGN_STMT:
+        assign(tokens[0], tokens[1], envs);
+        break;
+    case ASTNodeType::BINARY_ASSIGN_STMT:
+        assign(tokens[0], tokens[1], tokens[2], tokens[3], envs);
+        break;
+    case ASTNodeType::IF_STMT: {
+        const Token *cond = ast.getTokens(ast.getChild(node, 0));
+        branch(
+            cond[0], cond[1], cond[2],
+            [&](Envs &inner) { evaluate(ast, ast.getChild(node, 1), inner); },
+            [&](Envs &inner) { evaluate(ast, ast.getChild(node, 2), inner); },
+            envs);
+        break;
+    }
+    case ASTNodeType::WHILE_STMT: {
+        const Token *cond = ast.getTokens(ast.getChild(node, 0));
+        loop(
+            cond[0], cond[1], cond[2],
+            [&](Envs &inner) { evaluate(ast, ast.getChild(node, 1), inner); },
+            envs);
+        break;
+    }
+    case ASTNodeType::CHECK_STMT:
+        record(ast[node].label, tokens[1], envs);
+        break;
+    case ASTNodeType::NOP_STMT:
+        break;
+    default:
+        std::cerr << "[NaiveModelChecker] got "
+                  << getASTNodeSpelling(ast[node].type) << std::endl;
+        assert(false);
+    }
+}
+
+bool NaiveModelChecker::evaluate(const Token &leftOperand, const Token &op,
+                                 const Token &rightOperand, Env &env) {
+    Symbol variable = leftOperand.getSymbol();
     long long x = env[variable];
-    long long y = node->rightOperand.getLiteralAsNumber();
-    switch (node->op.type) {
+    long long y = rightOperand.getLiteralAsNumber();
+    switch (op.type) {
     case TokenType::EQUAL_EQUAL:
         return x == y;
     case TokenType::GREATER_EQUAL:
@@ -59,42 +138,44 @@ bool NaiveModelChecker::evaluate(Cond *node, Env &env) {
     case TokenType::LESS:
         return x < y;
     default:
-        std::cerr << "[NaiveModelChecker] got " << getASTNodeSpelling(*node)
-                  << std::endl;
+        std::cerr << "[NaiveModelChecker] got "
+                  << getASTNodeSpelling(ASTNodeType::COND) << std::endl;
         assert(false);
     }
     return false;
 }
 
-void NaiveModelChecker::evaluate(UnaryAssignStmt *node, Envs &envs) {
+void NaiveModelChecker::assign(const Token &variable, const Token &operand,
+                               Envs &envs) {
     Envs newEnvs;
-    std::string variable = node->variable.lexeme;
+    Symbol symbol = variable.getSymbol();
     for (auto &env : envs) {
-        switch (node->operand.type) {
+        switch (operand.type) {
         case TokenType::CALL_INPUT: {
             for (int i = 0; i < 256; i++) {
                 Env newEnv = env;
-                newEnv[variable] = i;
+                newEnv[symbol] = i;
                 newEnvs.insert(newEnv);
             }
             break;
         }
         case TokenType::NUMBER: {
             Env newEnv = env;
-            long long x = node->operand.getLiteralAsNumber();
-            newEnv[variable] = x;
+            long long x = operand.getLiteralAsNumber();
+            newEnv[symbol] = x;
             newEnvs.insert(newEnv);
             break;
         }
         case TokenType::IDENTIFIER: {
             Env newEnv = env;
-            long long x = newEnv[node->operand.lexeme];
-            newEnv[variable] = x;
+            long long x = newEnv[operand.getSymbol()];
+            newEnv[symbol] = x;
             newEnvs.insert(newEnv);
             break;
         }
         default:
-            std::cerr << "[NaiveModelChecker] got " << getASTNodeSpelling(*node)
+            std::cerr << "[NaiveModelChecker] got "
+                      << getASTNodeSpelling(ASTNodeType::UNARY_ASSIGN_STMT)
                       << std::endl;
             assert(false);
         }
@@ -102,26 +183,28 @@ void NaiveModelChecker::evaluate(UnaryAssignStmt *node, Envs &envs) {
     swap(envs, newEnvs);
 }
 
-void NaiveModelChecker::evaluate(BinaryAssignStmt *node, Envs &envs) {
+void NaiveModelChecker::assign(const Token &variable, const Token &leftOperand,
+                               const Token &op, const Token &rightOperand,
+                               Envs &envs) {
     Envs newEnvs;
-    std::string variable = node->variable.lexeme;
+    Symbol symbol = variable.getSymbol();
     for (auto &env : envs) {
         Env newEnv = env;
         long long x, y;
-        if (node->leftOperand.type == TokenType::IDENTIFIER)
-            x = newEnv[node->leftOperand.lexeme];
+        if (leftOperand.type == TokenType::IDENTIFIER)
+            x = newEnv[leftOperand.getSymbol()];
         else
-            x = node->leftOperand.getLiteralAsNumber();
-        if (node->rightOperand.type == TokenType::IDENTIFIER)
-            y = newEnv[node->rightOperand.lexeme];
+            x = leftOperand.getLiteralAsNumber();
+        if (rightOperand.type == TokenType::IDENTIFIER)
+            y = newEnv[rightOperand.getSymbol()];
         else
-            y = node->rightOperand.getLiteralAsNumber();
-        switch (node->op.type) {
+            y = rightOperand.getLiteralAsNumber();
+        switch (op.type) {
         case TokenType::PLUS:
-            newEnv[variable] = std::min(255ll, x + y);
+            newEnv[symbol] = std::min(255ll, x + y);
             break;
         case TokenType::MINUS:
-            newEnv[variable] = std::max(0ll, x - y);
+            newEnv[symbol] = std::max(0ll, x - y);
             break;
         default:
             assert(false);
@@ -131,22 +214,29 @@ void NaiveModelChecker::evaluate(BinaryAssignStmt *node, Envs &envs) {
     swap(envs, newEnvs);
 }
 
-void NaiveModelChecker::evaluate(IfStmt *node, Envs &envs) {
+void NaiveModelChecker::branch(const Token &leftOperand, const Token &op,
+                               const Token &rightOperand,
+                               const std::function<void(Envs &)> &trueBody,
+                               const std::function<void(Envs &)> &falseBody,
+                               Envs &envs) {
     Envs newEnvs;
     for (auto &env : envs) {
         Env newEnv = env;
         Envs candidateEnvs = {newEnv};
-        bool cond = evaluate((Cond *)node->cond, newEnv);
+        bool cond = evaluate(leftOperand, op, rightOperand, newEnv);
         if (cond)
-            evaluate((Stmts *)node->trueBody, candidateEnvs);
+            trueBody(candidateEnvs);
         else
-            evaluate((Stmts *)node->falseBody, candidateEnvs);
+            falseBody(candidateEnvs);
         newEnvs.insert(candidateEnvs.begin(), candidateEnvs.end());
     }
     swap(envs, newEnvs);
 }
 
-void NaiveModelChecker::evaluate(WhileStmt *node, Envs &envs) {
+void NaiveModelChecker::loop(const Token &leftOperand, const Token &op,
+                             const Token &rightOperand,
+                             const std::function<void(Envs &)> &body,
+                             Envs &envs) {
     Envs newEnvs;
     Envs visited = envs;
     std::queue<Env> q;
@@ -156,10 +246,10 @@ void NaiveModelChecker::evaluate(WhileStmt *node, Envs &envs) {
     while (!q.empty()) {
         Env newEnv = q.front();
         q.pop();
-        bool cond = evaluate((Cond *)node->cond, newEnv);
+        bool cond = evaluate(leftOperand, op, rightOperand, newEnv);
         if (cond) {
             Envs candidateEnvs = {newEnv};
-            evaluate((Stmts *)node->body, candidateEnvs);
+            body(candidateEnvs);
             for (auto &env : candidateEnvs) {
                 if (visited.count(env))
                     continue;
@@ -173,30 +263,44 @@ void NaiveModelChecker::evaluate(WhileStmt *node, Envs &envs) {
     swap(envs, newEnvs);
 }
 
-void NaiveModelChecker::evaluate(CheckStmt *node, Envs &envs) {
-    std::string variable = node->params[0].lexeme;
+void NaiveModelChecker::record(size_t label, const Token &variable,
+                               Envs &envs) {
+    Symbol symbol = variable.getSymbol();
     for (auto &env : envs) {
-        long long v = env.count(variable) ? env.at(variable) : 0ll;
-        reachableValue[node->label].set(v, 1);
+        long long v = env.count(symbol) ? env.at(symbol) : 0ll;
+        reachableValue[label].set(v, 1);
     }
 }
 
-void NaiveModelChecker::evaluate(NopStmt *node, Envs &envs) {}
-
 void NaiveModelChecker::run() {
-    root->accept(&info);
     Env initEnv;
     Envs initEnvs = {initEnv};
+    checks.clear();
+
+    if (flat) {
+        for (FlatAST::Index node = 0; node < flat->nodes.size(); node++)
+            if ((*flat)[node].type == ASTNodeType::CHECK_STMT)
+                checks.push_back({(*flat)[node].label, flat->getTokens(node),
+                                  flat->getTokens(node) + 1});
+        evaluate(*flat, 0, initEnvs);
+        return;
+    }
+
+    InfoCollector info;
+    root->accept(&info);
+    for (CheckStmt *check : info.checks)
+        checks.push_back({check->label, &check->check, check->params.data()});
     evaluate((Stmts *)root, initEnvs);
 }
 
 void NaiveModelChecker::dumpResult(std::ostream &out) {
-    for (auto &checkStmt : info.checks) {
-        size_t id = checkStmt->label;
-        std::string variable = checkStmt->params[0].lexeme;
-        long long l = checkStmt->params[1].getLiteralAsNumber();
-        long long r = checkStmt->params[2].getLiteralAsNumber();
-        out << "Line " << checkStmt->check.line << ": ";
+    for (auto &checkStmt : checks) {
+        size_t id = checkStmt.label;
+        const std::string &variable =
+            SymbolTable::get().getName(checkStmt.params[0].getSymbol());
+        long long l = checkStmt.params[1].getLiteralAsNumber();
+        long long r = checkStmt.params[2].getLiteralAsNumber();
+        out << "Line " << checkStmt.check->line << ": ";
         if (!reachableValue.count(id)) {
             out << "Unreachable" << std::endl;
             continue;
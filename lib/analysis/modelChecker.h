@@ -3,8 +3,10 @@
 
 #include "fdlang/AST.h"
 #include "fdlang/ASTVisitor.h"
+#include "fdlang/flatAST.h"
 
 #include <bitset>
+#include <functional>
 #include <map>
 #include <queue>
 #include <set>
@@ -34,17 +36,27 @@ public:
     std::vector<CheckStmt *> checks;
 };
 
+/**
+ * Model checker enumerating every reachable state, on an AST or a `FlatAST'
+ */
 class NaiveModelChecker {
 private:
-    ASTNode *root;
+    ASTNode *root = nullptr;
+    const FlatAST *flat = nullptr;
 
-    using Env = std::map<std::string, long long>;
+    using Env = std::map<Symbol, long long>;
     using Envs = std::set<Env>; // list of list of (identifier, value)
 
     // label -> valueSet
     std::unordered_map<size_t, std::bitset<256>> reachableValue;
 
-    InfoCollector info;
+    // The checks in the order of the program
+    struct CheckSite {
+        size_t label;
+        const Token *check;
+        const Token *params;
+    };
+    std::vector<CheckSite> checks;
 
     void evaluate(Stmts *node, Envs &envs);
     bool evaluate(Cond *node, Env &env);
@@ -55,9 +67,29 @@ private:
     void evaluate(CheckStmt *node, Envs &envs);
     void evaluate(NopStmt *node, Envs &envs);
 
+    void evaluate(const FlatAST &ast, FlatAST::Index node, Envs &envs);
+
+    // Shared by both ASTs, `branch' and `loop' evaluate the bodies by
+    // calling back
+    bool evaluate(const Token &leftOperand, const Token &op,
+                  const Token &rightOperand, Env &env);
+    void assign(const Token &variable, const Token &operand, Envs &envs);
+    void assign(const Token &variable, const Token &leftOperand,
+                const Token &op, const Token &rightOperand, Envs &envs);
+    void branch(const Token &leftOperand, const Token &op,
+                const Token &rightOperand,
+                const std::function<void(Envs &)> &trueBody,
+                const std::function<void(Envs &)> &falseBody, Envs &envs);
+    void loop(const Token &leftOperand, const Token &op,
+              const Token &rightOperand,
+              const std::function<void(Envs &)> &body, Envs &envs);
+    void record(size_t label, const Token &variable, Envs &envs);
+
 public:
     NaiveModelChecker(ASTNode *root) : root(root) {}
 
+    NaiveModelChecker(const FlatAST &ast) : flat(&ast) {}
+
     void run();
     void dumpResult(std::ostream &out);
 };
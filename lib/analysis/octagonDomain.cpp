@@ -0,0 +1,403 @@
+#include "octagonDomain.h"
+
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+using namespace fdlang::analysis;
+
+const long long OctagonDomain::INF = DBM::INF;
+
+/**
+ * @brief Construct a new Octagon Domain
+ *
+ * @param env appeared variables
+ * @param isInitialization true for initialization(all zero) and false for
+ * bottom
+ */
+OctagonDomain::OctagonDomain(std::shared_ptr<const VarEnv> env,
+                             bool isInitialization)
+    : _env(std::move(env)) {
+    n = _env->size();
+    // All variables are zero, and so are all their sums and differences.
+    // Bottom gets the storage as well, so that joins into it do not allocate.
+    _m.assign(2 * n * (n + 1), 0);
+    _bottom = !isInitialization;
+}
+
+DBM &OctagonDomain::expand() const {
+    // Shared by all octagons of the thread, every operation fills it anew
+    static thread_local DBM full;
+    if (full.size() != 2 * n)
+        full = DBM(2 * n, INF);
+
+    for (size_t i = 0; i < 2 * n; i++) {
+        for (size_t j = 0; j <= (i | 1); j++) {
+            Value c = _m[pos(i, j)];
+            full[i][j] = c;
+            full[j ^ 1][i ^ 1] = c;
+        }
+    }
+    return full;
+}
+
+void OctagonDomain::compress(const DBM &full) {
+    for (size_t i = 0; i < 2 * n; i++)
+        std::copy(full[i], full[i] + (i | 1) + 1, _m.begin() + pos(i, 0));
+}
+
+void OctagonDomain::setBottom() { _bottom = true; }
+
+void OctagonDomain::havoc(DBM &full, size_t v) {
+    size_t p = 2 * v, q = p + 1;
+    for (size_t i = 0; i < full.size(); i++)
+        full[i][p] = full[p][i] = full[i][q] = full[q][i] = INF;
+    full[p][p] = full[q][q] = 0;
+    // `2v <= 510' and `-2v <= 0'
+    full[q][p] = 2 * 255;
+    full[p][q] = 0;
+}
+
+void OctagonDomain::tighten(DBM &full, size_t i, size_t j, long long c) {
+    Value v = DBM::bound(c);
+    full[i][j] = std::min(full[i][j], v);
+    full[j ^ 1][i ^ 1] = std::min(full[j ^ 1][i ^ 1], v);
+}
+
+bool OctagonDomain::closeVar(DBM &full, size_t v) {
+    size_t m = full.size(), p = 2 * v, q = p + 1;
+
+    // The columns of `p' and `q' are the rows of `q' and `p' by coherence
+    auto mirrorColumns = [&] {
+        for (size_t i = 0; i < m; i++) {
+            full[i][p] = full[q][i ^ 1];
+            full[i][q] = full[p][i ^ 1];
+        }
+    };
+
+    // Shortest paths from `p' and `q' through the closed rest
+    for (size_t r : {p, q}) {
+        for (size_t k = 0; k < m; k++) {
+            Value rk = full[r][k];
+            if (k != p && k != q && rk < INF)
+                full.relaxRow(r, k, rk);
+        }
+    }
+    mirrorColumns();
+
+    // Between `p' and `q' through the rest, then through each other
+    for (auto [a, b] : {std::make_pair(p, q), std::make_pair(q, p)})
+        for (size_t k = 0; k < m; k++)
+            if (k != p && k != q)
+                full[a][b] = std::min(full[a][b],
+                                      DBM::add(full[a][k], full[k][b]));
+    if (full[p][q] < INF)
+        full.relaxRow(p, q, full[p][q]);
+    if (full[q][p] < INF)
+        full.relaxRow(q, p, full[q][p]);
+    mirrorColumns();
+
+    // A shortest path through `p' or `q' enters them once
+    for (size_t i = 0; i < m; i++) {
+        if (i == p || i == q)
+            continue;
+        if (full[i][p] < INF)
+            full.relaxRow(i, p, full[i][p]);
+        if (full[i][q] < INF)
+            full.relaxRow(i, q, full[i][q]);
+    }
+
+    return strengthen(full);
+}
+
+bool OctagonDomain::strengthen(DBM &full) {
+    size_t m = full.size();
+    for (size_t i = 0; i < m; i++)
+        if (full[i][i] < 0)
+            return false;
+
+    // Over integers, `2x <= c' is `2x <= 2 * floor(c / 2)'
+    ScratchArena::Frame frame;
+    Value *unary = ScratchArena::current().allocate<Value>(m);
+    for (size_t j = 0; j < m; j++) {
+        Value c = full[j ^ 1][j];
+        if (c < INF)
+            c -= c & 1;
+        full[j ^ 1][j] = unary[j] = c;
+    }
+
+    // `V_j - V_i <= (m[i][i ^ 1] + m[j ^ 1][j]) / 2', the bounds are even
+    for (size_t i = 0; i < m; i++) {
+        int c = unary[i ^ 1];
+        if (c >= INF)
+            continue;
+        Value *row = full[i];
+        for (size_t j = 0; j < m; j++) {
+            int half = unary[j] >= INF ? INF : (c + unary[j]) / 2;
+            row[j] = std::min((int)row[j], half);
+        }
+    }
+
+    for (size_t i = 0; i < m; i++)
+        if (full[i][i] < 0)
+            return false;
+    return true;
+}
+
+void OctagonDomain::dump(std::ostream &out) const {
+    if (isEmpty()) {
+        out << "; Unreachable" << std::endl;
+        return;
+    }
+
+    for (size_t x = 1; x < n; x++) {
+        IntervalDomain interval = projection(x);
+        out << "; " << getVar(x) << " = [" << interval.l << ", " << interval.r
+            << "]" << std::endl;
+    }
+
+    // `V_j - V_i <= m[i][j]', each once
+    for (size_t i = 2; i < 2 * n; i++) {
+        for (size_t j = 2; j <= (i | 1); j++) {
+            long long c = _m[pos(i, j)];
+            if (i / 2 == j / 2 || c >= INF)
+                continue;
+            out << "; " << (j % 2 ? "-" : "") << getVar(j / 2)
+                << (i % 2 ? " + " : " - ") << getVar(i / 2) << " <= " << c
+                << std::endl;
+        }
+    }
+}
+
+bool OctagonDomain::leq(const OctagonDomain &o) const {
+    if (this->isEmpty())
+        return true;
+    if (o.isEmpty())
+        return false;
+
+    int greater = 0;
+    for (size_t k = 0; k < _m.size(); k++)
+        greater |= _m[k] > o._m[k];
+    return !greater;
+}
+
+bool OctagonDomain::eq(const OctagonDomain &o) const {
+    if (this->isEmpty() || o.isEmpty())
+        return this->_bottom == o._bottom;
+    return _m == o._m;
+}
+
+IntervalDomain OctagonDomain::projection(size_t x) const {
+    if (isEmpty())
+        return IntervalDomain(INF, -INF);
+    // `-2x <= m[2x][2x + 1]' and `2x <= m[2x + 1][2x]'
+    long long lower = at(2 * x, 2 * x + 1), upper = at(2 * x + 1, 2 * x);
+    return IntervalDomain(lower >= INF ? -INF : -lower / 2,
+                          upper >= INF ? INF : upper / 2);
+}
+
+void OctagonDomain::joinWith(const OctagonDomain &o) {
+    if (this->isEmpty()) {
+        *this = o;
+        return;
+    }
+    if (o.isEmpty())
+        return;
+
+    // The maximum of tightly closed octagons is tightly closed
+    for (size_t k = 0; k < _m.size(); k++)
+        _m[k] = std::max(_m[k], o._m[k]);
+}
+
+void OctagonDomain::widenWith(const OctagonDomain &o,
+                              const std::vector<long long> &thresholds) {
+    if (this->isEmpty()) {
+        *this = o;
+        return;
+    }
+    if (o.isEmpty())
+        return;
+
+    for (size_t i = 0; i < 2 * n; i++) {
+        for (size_t j = 0; j <= (i | 1); j++) {
+            Value &c = _m[pos(i, j)];
+            Value joined = std::max(c, o._m[pos(i, j)]);
+            if (joined <= c)
+                continue;
+            if (j != (i ^ 1) || joined >= INF) {
+                c = INF;
+                continue;
+            }
+
+            // `2x <= c' for odd i and `-2x <= c' for even i
+            if (i % 2) {
+                long long upper = widenUpper(thresholds, joined / 2);
+                c = upper == LLONG_MAX ? INF : DBM::bound(2 * upper);
+            } else {
+                long long lower = widenLower(thresholds, -joined / 2);
+                c = lower == LLONG_MIN ? INF : DBM::bound(-2 * lower);
+            }
+        }
+    }
+
+    // The bounds only grow, so the closure finds no negative cycle
+    DBM &full = expand();
+    full.close();
+    if (!strengthen(full)) {
+        setBottom();
+        return;
+    }
+    compress(full);
+}
+
+void OctagonDomain::apply(const ZoneOp &op) {
+    // Only `x = c - y' has a single variable
+    if (op.kind != ZoneOp::Kind::AssignInterval || op.sy == 0 ||
+        (op.sz == 0 && op.sy != -1) || this->isEmpty()) {
+        ZoneTransfer<OctagonDomain>::apply(op);
+        return;
+    }
+
+    // Results saturate to [0, 255], and the constraints below which hold only
+    // without saturation are added when it cannot happen
+    size_t x = op.x, y = op.y, z = op.z;
+    IntervalDomain iy = projection(y);
+    ScratchArena::Frame frame;
+    ScratchVector<Constraint> extra(4);
+    long long l, r;
+
+    if (op.sz == 0) {
+        // x = c - y, that is `x + y >= c' for c - y <= 255 and `x + y <= c'
+        // for y <= c
+        long long c = op.l;
+        l = c - iy.r, r = c - iy.l;
+        if (y != x) {
+            if (c - iy.l <= 255)
+                extra.push_back({2 * y, 2 * x + 1, -c});
+            if (iy.r <= c)
+                extra.push_back({2 * y + 1, 2 * x, c});
+        }
+    } else {
+        // x = y + z or x = y - z, bounded by the sum or the difference of
+        // `y' and `z' which the octagon knows better than the intervals
+        size_t ny = 2 * y, nz = op.sz > 0 ? 2 * z : 2 * z + 1;
+        long long upper = at(nz ^ 1, ny), lower = at(nz, ny ^ 1);
+        l = op.l - lower, r = op.r + upper;
+
+        IntervalDomain iz = projection(z);
+        if (y != x && z != x && op.sz > 0) {
+            extra.push_back({2 * y, 2 * x, iz.r});
+            extra.push_back({2 * z, 2 * x, iy.r});
+            if (iy.r + iz.r <= 255) {
+                extra.push_back({2 * x, 2 * y, -iz.l});
+                extra.push_back({2 * x, 2 * z, -iy.l});
+            }
+        } else if (y != x && z != x) {
+            extra.push_back({2 * x, 2 * y, iz.r});
+            extra.push_back({2 * z, 2 * x + 1, -iy.l});
+            if (iy.l - iz.r >= 0) {
+                extra.push_back({2 * y, 2 * x, -iz.l});
+                extra.push_back({2 * z + 1, 2 * x, iy.r});
+            }
+        }
+    }
+
+    assignWith(x, l, r, extra);
+}
+
+void OctagonDomain::filter(size_t x, size_t y, long long c) {
+    // `V_2x - V_2y <= c' only touches the rows and columns of `x'
+    if (this->isEmpty() || DBM::bound(c) >= at(2 * y, 2 * x))
+        return;
+
+    DBM &full = expand();
+    tighten(full, 2 * y, 2 * x, c);
+    if (!closeVar(full, x)) {
+        setBottom();
+        return;
+    }
+    compress(full);
+}
+
+void OctagonDomain::assign(size_t x, size_t y, long long c) {
+    if (this->isEmpty())
+        return;
+    size_t p = 2 * x, q = p + 1;
+
+    if (y != x) {
+        // `x - y = c' holds unless `y + c' saturates, and then only
+        // `x - y <= c' for c > 0 or `x - y >= c' for c < 0 does
+        IntervalDomain iy = projection(y);
+        ScratchArena::Frame frame;
+        ScratchVector<Constraint> extra(2);
+        if (iy.l + c >= 0)
+            extra.push_back({2 * y, p, c});
+        if (iy.r + c <= 255)
+            extra.push_back({p, 2 * y, -c});
+        assignWith(x, iy.l + c, iy.r + c, extra);
+        return;
+    }
+
+    // The new `x' is `min(255, x + c)' for c >= 0 and `max(0, x + c)' for
+    // c < 0. When it may saturate, the bounds on `V_j - x' or `V_j + x'
+    // which grow by saturation fall back to the ones of `V_j' at 255 or 0.
+    IntervalDomain interval = projection(x);
+    bool saturates = c >= 0 ? interval.r + c > 255 : interval.l + c < 0;
+    long long edge = c >= 0 ? 255 : 0;
+
+    DBM &full = expand();
+    // Bound of `V_j - x' given that of `V_j - x - c', and of `V_j' for x = edge
+    auto shift = [&](Value d, size_t j, long long sign) -> Value {
+        Value moved = DBM::add(d, DBM::bound(-sign * c));
+        if (!saturates || sign * c < 0)
+            return moved;
+        Value unary = full[j ^ 1][j];
+        if (moved == INF || unary == INF)
+            return INF;
+        return std::max(moved, DBM::bound(unary / 2 - sign * edge));
+    };
+    for (size_t j = 0; j < full.size(); j++) {
+        if (j == p || j == q)
+            continue;
+        full[p][j] = shift(full[p][j], j, 1);
+        full[j ^ 1][q] = full[p][j];
+        full[q][j] = shift(full[q][j], j, -1);
+        full[j ^ 1][p] = full[q][j];
+    }
+    long long r = std::clamp(interval.r + c, 0ll, 255ll);
+    long long l = std::clamp(interval.l + c, 0ll, 255ll);
+    full[q][p] = DBM::bound(2 * r);
+    full[p][q] = DBM::bound(-2 * l);
+
+    if (saturates && !closeVar(full, x)) {
+        setBottom();
+        return;
+    }
+    compress(full);
+}
+
+void OctagonDomain::assignInterval(size_t x, long long l, long long r) {
+    ScratchArena::Frame frame;
+    assignWith(x, l, r, ScratchVector<Constraint>(0));
+}
+
+void OctagonDomain::assignWith(size_t x, long long l, long long r,
+                               const ScratchVector<Constraint> &extra) {
+    // Saturated results stay in [0, 255]
+    l = std::clamp(l, 0ll, 255ll);
+    r = std::clamp(r, 0ll, 255ll);
+    if (this->isEmpty())
+        return;
+
+    DBM &full = expand();
+    havoc(full, x);
+    tighten(full, 2 * x + 1, 2 * x, 2 * r);
+    tighten(full, 2 * x, 2 * x + 1, -2 * l);
+    for (auto [i, j, c] : extra)
+        tighten(full, i, j, c);
+    if (!closeVar(full, x)) {
+        setBottom();
+        return;
+    }
+    compress(full);
+}
@@ -0,0 +1,182 @@
+#ifndef ANALYSIS_OCTAGONDOMAIN_H
+#define ANALYSIS_OCTAGONDOMAIN_H
+
+#include "IR/IR.h"
+#include "dbm.h"
+#include "scratchArena.h"
+#include "zoneTransfer.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fdlang::analysis {
+
+/**
+ * Octagon, the conjunction of constraints `+-x +-y <= c'
+ *
+ * Every variable x has a positive node 2x for `+x' and a negative node
+ * 2x + 1 for `-x', and the 2n x 2n matrix `m[i][j]' bounds `V_j - V_i' like
+ * the one of `ZoneDomain'. Id 0 is a variable pinned to zero, so the guards
+ * and assignments of `ZoneTransfer' keep their meaning.
+ *
+ * The matrix is coherent, `m[i][j] = m[j ^ 1][i ^ 1]', so only its lower
+ * half `j <= (i | 1)' is stored. It is kept tightly closed: closed, with even
+ * unary bounds `m[i][i ^ 1]', and strengthened, which makes it the normal
+ * form over integers. The closures run on a full scratch matrix with the
+ * SIMD kernels of `DBM'.
+ */
+class OctagonDomain : public ZoneTransfer<OctagonDomain> {
+private:
+    using Value = DBM::Value;
+    static const long long INF;
+    size_t n = 0;
+
+    std::shared_ptr<const VarEnv> _env;
+
+    // Row i holds `m[i][0..(i | 1)]', meaningless for bottom
+    std::vector<Value> _m;
+
+    bool _bottom = false;
+
+    // `m[i][j] <= c'
+    struct Constraint {
+        size_t i, j;
+        long long c;
+    };
+
+    const std::string &getVar(size_t id) const { return _env->getVar(id); }
+
+    size_t getID(const std::string &x) const { return _env->getID(x); }
+
+    static size_t pos(size_t i, size_t j) { return j + (i + 1) * (i + 1) / 2; }
+
+    /**
+     * @brief Get `m[i][j]' from the stored half
+     */
+    Value at(size_t i, size_t j) const {
+        return j <= (i | 1) ? _m[pos(i, j)] : _m[pos(j ^ 1, i ^ 1)];
+    }
+
+    /**
+     * @brief Get the scratch matrix holding the full `m'
+     */
+    DBM &expand() const;
+
+    /**
+     * @brief Store the lower half of `full'
+     */
+    void compress(const DBM &full);
+
+    void setBottom();
+
+    /**
+     * @brief Drop every constraint on `v' except `0 <= v <= 255'
+     */
+    static void havoc(DBM &full, size_t v);
+
+    /**
+     * @brief Set `full[i][j]' and its coherent entry to at most `c'
+     */
+    static void tighten(DBM &full, size_t i, size_t j, long long c);
+
+    /**
+     * @brief Restore the tight closure after rewriting the rows and columns
+     * of `v'
+     *
+     * Assume the rest of `full' is tightly closed. Return false if it turns
+     * out to be empty.
+     */
+    static bool closeVar(DBM &full, size_t v);
+
+    /**
+     * @brief Make a closed `full' tight and strengthen it
+     *
+     * Return false if it turns out to be empty.
+     */
+    static bool strengthen(DBM &full);
+
+    /**
+     * @brief Excute `x = [l, r]' and add `extra' on the new `x'
+     */
+    void assignWith(size_t x, long long l, long long r,
+                    const ScratchVector<Constraint> &extra);
+
+public:
+    /**
+     * @brief Construct a new Octagon Domain
+     *
+     * @param env appeared variables
+     * @param isInitialization true for initialization(all zero) and false for
+     * bottom
+     */
+    OctagonDomain(std::shared_ptr<const VarEnv> env, bool isInitialization);
+    OctagonDomain() = default;
+
+    const VarEnv &env() const { return *_env; }
+
+    void dump(std::ostream &out) const;
+
+    /**
+     * @brief Test if `*this' is bottom
+     */
+    bool isEmpty() const { return _bottom; }
+
+    /**
+     * @brief Test if `*this' is less or equal than `o' in partial order <=
+     */
+    bool leq(const OctagonDomain &o) const;
+
+    /**
+     * @brief Test if `*this' is equal to `o'
+     */
+    bool eq(const OctagonDomain &o) const;
+
+    /**
+     * @brief Get the projection of `*this' on the variable `x'
+     */
+    IntervalDomain projection(size_t x) const;
+
+    /**
+     * @brief Join `o' into `*this'
+     */
+    void joinWith(const OctagonDomain &o);
+
+    /**
+     * @brief Widen `*this' with `o'
+     *
+     * Unstable bounds jump to the next of the sorted `thresholds', other
+     * unstable constraints are dropped.
+     */
+    void widenWith(const OctagonDomain &o,
+                   const std::vector<long long> &thresholds);
+
+    /**
+     * @brief Apply `op' to `*this'
+     *
+     * Unlike zones, `x = c - y', `x = y + z' and `x = y - z' keep the sums
+     * and differences they imply between `x', `y' and `z'.
+     */
+    void apply(const ZoneOp &op);
+
+    /**
+     * @brief Filter by guard `x - y <= c'
+     */
+    void filter(size_t x, size_t y, long long c);
+
+    /**
+     * @brief Excute `x = y + c'
+     *
+     * It is `x = x + c' for y == x and `x = c' for y == 0.
+     */
+    void assign(size_t x, size_t y, long long c);
+
+    /**
+     * @brief Excute `x = [l, r]'
+     */
+    void assignInterval(size_t x, long long l, long long r);
+};
+
+} // namespace fdlang::analysis
+
+#endif
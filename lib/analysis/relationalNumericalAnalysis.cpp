@@ -1,135 +1,185 @@
 #include "relationalNumericalAnalysis.h"
+#include "variableOrder.h"
 
 #include "IR/IR.h"
 
 #include <algorithm>
 #include <array>
 #include <memory>
-#include <queue>
-#include <unordered_set>
 #include <vector>
 
 using namespace fdlang;
 using namespace fdlang::analysis;
 
+template <typename States>
 void RelationalNumericalAnalysis::dumpStates(std::ostream &out,
                                              States &states) {
     states.dump(out);
 }
 
-RelationalNumericalAnalysis::States
-RelationalNumericalAnalysis::transferAssignment(const IR::Inst *inst,
-                                                States &input) {
-    return input.assignInst(inst);
-}
-
-RelationalNumericalAnalysis::States
-RelationalNumericalAnalysis::transferIfStmt(const IR::IfInst *inst,
-                                            States &input, bool branch) {
-    return input.filterInst(inst, branch);
-}
-
-RelationalNumericalAnalysis::States
-RelationalNumericalAnalysis::transferIdentity(const IR::Inst *inst,
-                                              States &input) {
-    return input;
+template <typename States>
+void RelationalNumericalAnalysis::transfer(const ZoneOp &op,
+                                           const States &input,
+                                           States &output) {
+    if (transferHook)
+        transferHook(iterations);
+    iterations++;
+    output = input;
+    output.apply(op);
 }
 
+template <typename States>
 bool RelationalNumericalAnalysis::joinInto(const States &x, States &y) {
-    States before = y;
+    // The join strictly grows `y' unless `x <= y'
+    if (x.leq(y))
+        return false;
+
+    // Copies keep the storage of `y', bottom included
+    if (y.isEmpty())
+        y = x;
+    else
+        y.joinWith(x);
+    return true;
+}
 
-    y = x.lub(y);
+template <typename States>
+bool RelationalNumericalAnalysis::widenInto(const States &x, States &y) {
+    if (x.leq(y))
+        return false;
 
-    return !before.eq(y);
+    y.widenWith(x, thresholds);
+    return true;
 }
 
 void RelationalNumericalAnalysis::run() {
+    // An empty program has no label to start from, nor any check
+    if (insts.empty())
+        return;
 
-    // Collecting the name of variables
+    // Collecting the name of variables, related ones get close ids
     // std::cerr << "[zone-analysis] Collecting the name of variables"
     //   << std::endl;
-    std::unordered_set<std::string> varsSet;
-    for (auto inst : insts) {
-        for (int i = 0; i < inst->getOperandSize(); i++) {
-            if (!inst->getOperand(i)->isVariable())
-                continue;
-            varsSet.insert(inst->getOperand(i)->getAsVariable());
-        }
-    }
-    std::vector<std::string> vars(varsSet.begin(), varsSet.end());
+    std::vector<Symbol> vars = orderVariables(insts);
+
+    // Collecting the widening thresholds and the loop heads, which are the
+    // targets of backward edges
+    collectThresholds();
+    findLoopHeads();
+
+    // Lowering the instructions once, so that the worklist runs on variable
+    // ids only
+    auto env = std::make_shared<const VarEnv>(vars);
+    edgeOps.assign(insts.size(), {});
+    for (auto inst : insts)
+        for (size_t i = 0; i < inst->getSuccessors().size(); i++)
+            edgeOps[inst->getLabel()].push_back(ZoneOp::lower(inst, i, *env));
+
+    // The dense matrix costs n^2 per state whatever the relations are, and
+    // small ones are cheaper without the heap. A component large enough for
+    // the tiled closure is worth the matrix once threads share it.
+    bool split = kind == ZoneKind::Split ||
+                 (kind == ZoneKind::Auto && vars.size() >= SPLIT_THRESHOLD &&
+                  (DBM::threads() == 1 ||
+                   largestComponent(insts) < DBM::blockedSize()));
+    iterations = 0;
+    if (kind == ZoneKind::Octagon)
+        solve<OctagonDomain>(env);
+    else if (split)
+        solve<SplitZoneDomain>(env);
+    else if (kind == ZoneKind::Dense || env->size() > FIXED_LIMIT)
+        solve<ZoneDomain>(env);
+    else if (env->size() <= 4)
+        solve<FixedZoneDomain<4>>(env);
+    else if (env->size() <= 8)
+        solve<FixedZoneDomain<8>>(env);
+    else if (env->size() <= 16)
+        solve<FixedZoneDomain<16>>(env);
+    else
+        solve<FixedZoneDomain<FIXED_LIMIT>>(env);
+}
 
+template <typename States>
+void RelationalNumericalAnalysis::solve(
+    const std::shared_ptr<const VarEnv> &env) {
     // Initializing the states
     // std::cerr << "[zone-analysis] Initializing the states" << std::endl;
-    States initState(vars, true), bottomState(vars, false);
+    ScratchArena::Use use(arena);
+    States initState(env, true), bottomState(env, false);
+    // Output of the current transfer
+    States outputState = bottomState;
+
+    // label -> states
+    std::vector<States> inputStates(insts.size(), bottomState);
+    inputStates[0] = initState;
+
+    // Edges into each label, for the narrowing
+    std::vector<std::vector<std::pair<size_t, size_t>>> preds(insts.size());
     for (auto inst : insts) {
-        size_t label = inst->getLabel();
-        if (label == 0)
-            inputStates[label] = initState;
-        else
-            inputStates[label] = bottomState;
+        const auto &succs = inst->getSuccessors();
+        for (size_t i = 0; i < succs.size(); i++)
+            preds[succs[i]->getLabel()].emplace_back(inst->getLabel(), i);
     }
+    States state = bottomState;
 
     // Worklist algorithm
     // std::cerr << "[zone-analysis] Worklist algorithm" << std::endl;
     std::vector<bool> inQueue(insts.size(), false);
-    std::queue<size_t> q;
-    q.push(0), inQueue[0] = true;
+    std::vector<size_t> joins(insts.size(), 0);
+
+    // FIFO of the labels, each of them is queued at most once
+    std::vector<size_t> q(insts.size());
+    size_t head = 0, queued = 0;
+    auto push = [&](size_t label) {
+        q[(head + queued++) % q.size()] = label;
+        inQueue[label] = true;
+    };
+    push(0);
 
     auto tryToEnqueue = [&](const States &outputState, const size_t succ) {
-        if (joinInto(outputState, inputStates[succ]) && !inQueue[succ]) {
-            inQueue[succ] = true;
-            q.push(succ);
-        }
+        bool changed;
+        if (loopHeads[succ] && ++joins[succ] > WIDENING_DELAY)
+            changed = widenInto(outputState, inputStates[succ]);
+        else
+            changed = joinInto(outputState, inputStates[succ]);
+        if (changed && !inQueue[succ])
+            push(succ);
     };
 
-    while (!q.empty()) {
-        size_t now = q.front();
-        q.pop();
+    while (queued > 0) {
+        size_t now = q[head];
+        head = (head + 1) % q.size(), queued--;
         inQueue[now] = false;
 
         IR::Inst *inst = insts[now];
-        States &inputState = inputStates[now];
-        States outputState;
 
-        if (inst->getInstType() == IR::InstType::IfInst) {
-            IR::IfInst *ifInst = (IR::IfInst *)inst;
-            size_t succ;
-
-            // false branch
-            outputState = transferIfStmt(ifInst, inputState, false);
-            succ = inst->getSuccessors()[0]->getLabel();
+        const auto &succs = inst->getSuccessors();
+        for (size_t i = 0; i < succs.size(); i++) {
+            transfer(edgeOps[now][i], inputStates[now], outputState);
             if (!outputState.isEmpty())
-                tryToEnqueue(outputState, succ);
-
-            // true branch
-            outputState = transferIfStmt(ifInst, inputState, true);
-            succ = inst->getSuccessors()[1]->getLabel();
-            if (!outputState.isEmpty())
-                tryToEnqueue(outputState, succ);
-
-            continue;
-        }
-
-        switch (inst->getInstType()) {
-        case IR::InstType::AddInst:
-        case IR::InstType::SubInst:
-        case IR::InstType::AssignInst:
-        case IR::InstType::InputInst:
-            outputState = transferAssignment(inst, inputState);
-            break;
-        case IR::InstType::CheckIntervalInst:
-        case IR::InstType::LabelInst:
-        case IR::InstType::GotoInst:
-            outputState = transferIdentity(inst, inputState);
-            break;
-        default:
-            assert(false);
+                tryToEnqueue(outputState, succs[i]->getLabel());
         }
+    }
 
-        if (!inst->getSuccessors().empty()) {
-            size_t succ = inst->getSuccessors()[0]->getLabel();
-            tryToEnqueue(outputState, succ);
+    // Narrowing: the widened states are a post-fixpoint, so recomputing them
+    // from their predecessors can only make them smaller and stays sound
+    // std::cerr << "[zone-analysis] Narrowing" << std::endl;
+    for (size_t round = 0; round < NARROWING_ROUNDS; round++) {
+        bool changed = false;
+        for (auto inst : insts) {
+            size_t label = inst->getLabel();
+            state = label == 0 ? initState : bottomState;
+            for (auto [pred, i] : preds[label]) {
+                transfer(edgeOps[pred][i], inputStates[pred], outputState);
+                if (!outputState.isEmpty())
+                    joinInto(outputState, state);
+            }
+            if (!state.eq(inputStates[label])) {
+                inputStates[label] = state;
+                changed = true;
+            }
         }
+        if (!changed)
+            break;
     }
 
     // Answering the queries
@@ -138,7 +188,7 @@ void RelationalNumericalAnalysis::run() {
         if (inst->getInstType() != IR::InstType::CheckIntervalInst)
             continue;
         IR::CheckIntervalInst *checkInst = (IR::CheckIntervalInst *)inst;
-        std::string variable = checkInst->getOperand(0)->getAsVariable();
+        Symbol variable = checkInst->getOperand(0)->getAsVariable();
         long long l = checkInst->getOperand(1)->getAsNumber();
         long long r = checkInst->getOperand(2)->getAsNumber();
 
@@ -148,7 +198,7 @@ void RelationalNumericalAnalysis::run() {
         }
 
         IntervalDomain interval =
-            inputStates[inst->getLabel()].projection(variable);
+            inputStates[inst->getLabel()].projection(env->getID(variable));
         if (l <= interval.l && interval.r <= r)
             results[checkInst] = ResultType::YES;
         else
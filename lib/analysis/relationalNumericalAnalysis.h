@@ -2,10 +2,16 @@
 #define ANALYSIS_RELATIONALNUMERICALANALYSIS_H
 
 #include "dataflowAnalysis.h"
+#include "fixedZoneDomain.h"
+#include "octagonDomain.h"
+#include "scratchArena.h"
+#include "splitZoneDomain.h"
 #include "zoneDomain.h"
 
 #include <algorithm>
+#include <functional>
 #include <map>
+#include <memory>
 #include <vector>
 
 namespace fdlang::analysis {
@@ -14,50 +20,78 @@ class RelationalNumericalAnalysis : public DataflowAnalysis {
 public:
     enum class ResultType { YES, NO, UNREACHABLE };
 
+    /**
+     * Representation of the zones: `Dense' is `ZoneDomain', `Split' is
+     * `SplitZoneDomain' and `Fixed' is the smallest `FixedZoneDomain' the
+     * variables fit in, up to `FIXED_LIMIT' ids, or `Dense' above. `Auto'
+     * picks `Fixed' while the variables fit and `Split' from
+     * `SPLIT_THRESHOLD' variables on, unless `DBM::useThreads' asked for
+     * several threads and a component can reach `DBM::blockedSize()'
+     * variables: `Dense' then closes it by tiles. `Octagon' runs
+     * `OctagonDomain' instead of zones.
+     */
+    enum class ZoneKind { Auto, Dense, Split, Fixed, Octagon };
+    static constexpr size_t FIXED_LIMIT = 32;
+    static constexpr size_t SPLIT_THRESHOLD = 128;
+
 private:
     std::map<IR::CheckIntervalInst *, ResultType> results;
+    ZoneKind kind;
+
+    // label -> operations on the edges to the successors
+    std::vector<std::vector<ZoneOp>> edgeOps;
+
+    // Transfers computed by the worklist and the narrowing
+    size_t iterations = 0;
+
+    // Temporaries of the domain operations during `run', so that once warmed
+    // up the fixpoint iterates without heap allocations
+    ScratchArena arena;
+    std::function<void(size_t)> transferHook;
 
 public:
-    RelationalNumericalAnalysis(const IR::Insts &insts)
-        : DataflowAnalysis(insts) {}
+    RelationalNumericalAnalysis(const IR::Insts &insts,
+                                ZoneKind kind = ZoneKind::Auto)
+        : DataflowAnalysis(insts), kind(kind) {}
 
     void dumpResult(std::ostream &out) override {
-        using Location = std::pair<size_t, size_t>;
-
-        std::vector<std::pair<Location, ResultType>> ans;
-        for (auto [checkInst, result] : results) {
-            ans.emplace_back(
-                (Location){checkInst->getLine(), checkInst->getLabel()},
-                result);
-        }
-        std::sort(ans.begin(), ans.end());
-
-        for (auto [loc, result] : ans) {
-            auto [line, label] = loc;
-            out << "Line " << line << ": ";
-            if (result == ResultType::UNREACHABLE) {
-                out << "Unreachable" << std::endl;
-                continue;
-            }
-            out << (result == ResultType::YES ? "YES" : " NO") << std::endl;
-        }
+        dumpResults(out, results);
     }
 
     void run() override;
 
-private:
-    using States = ZoneDomain;
+    size_t getIterations() const { return iterations; }
 
-    // label -> states
-    std::map<size_t, States> inputStates;
+    /**
+     * @brief Call `hook' with the number of transfers done so far before
+     * every transfer, for tests and profiling
+     */
+    void setTransferHook(std::function<void(size_t)> hook) {
+        transferHook = std::move(hook);
+    }
 
-    States transferAssignment(const IR::Inst *inst, States &input);
-    States transferIdentity(const IR::Inst *inst, States &input);
-    States transferIfStmt(const IR::IfInst *inst, States &input, bool branch);
+private:
+    /**
+     * @brief Run the worklist algorithm with zones of type `States' and
+     * answer the queries
+     */
+    template <typename States>
+    void solve(const std::shared_ptr<const VarEnv> &env);
+
+    /**
+     * @brief Compute in `output' the output of the edge lowered to `op',
+     * reusing its storage
+     */
+    template <typename States>
+    void transfer(const ZoneOp &op, const States &input, States &output);
 
     // x join into y
-    bool joinInto(const States &x, States &y);
+    template <typename States> bool joinInto(const States &x, States &y);
+
+    // y widened with x
+    template <typename States> bool widenInto(const States &x, States &y);
 
+    template <typename States>
     void dumpStates(std::ostream &out, States &states);
 };
 
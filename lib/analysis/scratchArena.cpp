@@ -0,0 +1,67 @@
+#include "scratchArena.h"
+
+#include <algorithm>
+
+using namespace fdlang::analysis;
+
+namespace {
+
+// Arena made current by `ScratchArena::Use', if any
+thread_local ScratchArena *installed = nullptr;
+
+} // namespace
+
+ScratchArena::Frame::Frame(ScratchArena &arena)
+    : arena(arena), chunk(arena.chunk), used(arena.used),
+      matrices(arena.matrices) {}
+
+ScratchArena::Frame::~Frame() {
+    arena.chunk = chunk;
+    arena.used = used;
+    arena.matrices = matrices;
+}
+
+ScratchArena::Use::Use(ScratchArena &arena) : previous(installed) {
+    installed = &arena;
+}
+
+ScratchArena::Use::~Use() { installed = previous; }
+
+ScratchArena &ScratchArena::current() {
+    static thread_local ScratchArena own;
+    return installed ? *installed : own;
+}
+
+void *ScratchArena::allocateBytes(size_t bytes) {
+    bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    // Chunks too small for `bytes' are skipped, and stay for later frames
+    while (chunk < chunks.size() && used + bytes > chunks[chunk].size)
+        chunk++, used = 0;
+    if (chunk == chunks.size()) {
+        size_t size = chunks.empty() ? MIN_CHUNK : 2 * chunks.back().size;
+        size = std::max(size, bytes);
+        chunks.push_back({std::make_unique<std::byte[]>(size), size});
+        used = 0;
+    }
+
+    void *p = chunks[chunk].data.get() + used;
+    used += bytes;
+    return p;
+}
+
+DBM &ScratchArena::matrix(size_t n, DBM::Value init) {
+    if (matrices == pool.size())
+        pool.push_back(std::make_unique<DBM>());
+    DBM &m = *pool[matrices++];
+    m.assign(n, init);
+    return m;
+}
+
+DBM &ScratchArena::matrix(const DBM &o) {
+    if (matrices == pool.size())
+        pool.push_back(std::make_unique<DBM>());
+    DBM &m = *pool[matrices++];
+    m = o;
+    return m;
+}
@@ -0,0 +1,159 @@
+#ifndef ANALYSIS_SCRATCHARENA_H
+#define ANALYSIS_SCRATCHARENA_H
+
+#include "dbm.h"
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace fdlang::analysis {
+
+/**
+ * Memory for the temporaries of the domain operations
+ *
+ * Temporaries are carved from chunks which the arena keeps until it dies, and
+ * everything taken since a `Frame' started is given back when it ends. Once
+ * the chunks have grown to the largest operation, the temporaries no longer
+ * touch the heap. Scratch matrices are pooled the same way.
+ *
+ * Every thread has an arena of its own, and `Use' makes another one current
+ * for a scope, which is how an analysis owns the memory of its fixpoint.
+ *
+ * Only the temporaries live here. The states keep their own storage, so a
+ * split zone still allocates when one of its adjacency lists grows past any
+ * size it had before.
+ */
+class ScratchArena {
+private:
+    static constexpr size_t ALIGNMENT = alignof(std::max_align_t);
+    static constexpr size_t MIN_CHUNK = 4096;
+
+    struct Chunk {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+    std::vector<Chunk> chunks;
+    // Chunk being carved, and its bytes in use
+    size_t chunk = 0, used = 0;
+
+    // Pooled matrices, the first `matrices' of them are taken
+    std::vector<std::unique_ptr<DBM>> pool;
+    size_t matrices = 0;
+
+    void *allocateBytes(size_t bytes);
+
+public:
+    /**
+     * Scope of temporaries, which gives back everything taken from the arena
+     * since it started
+     */
+    class Frame {
+    private:
+        ScratchArena &arena;
+        size_t chunk, used, matrices;
+
+    public:
+        explicit Frame(ScratchArena &arena = current());
+        ~Frame();
+        Frame(const Frame &) = delete;
+        Frame &operator=(const Frame &) = delete;
+    };
+
+    /**
+     * Makes an arena the current one of the thread during a scope
+     */
+    class Use {
+    private:
+        ScratchArena *previous;
+
+    public:
+        explicit Use(ScratchArena &arena);
+        ~Use();
+        Use(const Use &) = delete;
+        Use &operator=(const Use &) = delete;
+    };
+
+    ScratchArena() = default;
+    ScratchArena(const ScratchArena &) = delete;
+    ScratchArena &operator=(const ScratchArena &) = delete;
+
+    /**
+     * @brief Get the current arena of the calling thread
+     */
+    static ScratchArena &current();
+
+    /**
+     * @brief Get room for `count' objects of `T', until the current frame
+     * ends
+     */
+    template <typename T> T *allocate(size_t count) {
+        static_assert(std::is_trivially_destructible_v<T>);
+        return static_cast<T *>(allocateBytes(count * sizeof(T)));
+    }
+
+    /**
+     * @brief Get a scratch `n' x `n' matrix with every entry `init'
+     */
+    DBM &matrix(size_t n, DBM::Value init);
+
+    /**
+     * @brief Get a scratch copy of `o'
+     */
+    DBM &matrix(const DBM &o);
+
+    /**
+     * @brief Get the number of chunks, which only grows while the arena
+     * warms up
+     */
+    size_t getChunks() const { return chunks.size(); }
+};
+
+/**
+ * Vector of at most `capacity' trivial `T' in the memory of an arena
+ */
+template <typename T> class ScratchVector {
+private:
+    T *_data;
+    size_t _size = 0, _capacity;
+
+public:
+    explicit ScratchVector(size_t capacity,
+                           ScratchArena &arena = ScratchArena::current())
+        : _data(arena.allocate<T>(capacity)), _capacity(capacity) {}
+
+    size_t size() const { return _size; }
+
+    bool empty() const { return _size == 0; }
+
+    void push_back(const T &v) {
+        assert(_size < _capacity);
+        _data[_size++] = v;
+    }
+
+    /**
+     * @brief Keep the first `size' elements
+     */
+    void resize(size_t size) {
+        assert(size <= _capacity);
+        _size = size;
+    }
+
+    T &operator[](size_t i) { return _data[i]; }
+
+    const T &operator[](size_t i) const { return _data[i]; }
+
+    T *begin() { return _data; }
+
+    T *end() { return _data + _size; }
+
+    const T *begin() const { return _data; }
+
+    const T *end() const { return _data + _size; }
+};
+
+} // namespace fdlang::analysis
+
+#endif
@@ -0,0 +1,582 @@
+#include "splitZoneDomain.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+using namespace fdlang::analysis;
+
+const long long SplitZoneDomain::INF = DBM::INF;
+
+namespace {
+
+using Edge = std::pair<uint32_t, DBM::Value>;
+using Edges = std::vector<Edge>;
+
+template <typename Range> auto lookup(Range &edges, size_t v) {
+    return std::lower_bound(
+        edges.begin(), edges.end(), v,
+        [](const std::pair<uint32_t, DBM::Value> &e, size_t v) {
+            return e.first < v;
+        });
+}
+
+void store(Edges &edges, size_t v, DBM::Value w) {
+    auto it = lookup(edges, v);
+    if (it != edges.end() && it->first == v)
+        it->second = w;
+    else
+        edges.insert(it, {(uint32_t)v, w});
+}
+
+void erase(Edges &edges, size_t v) {
+    auto it = lookup(edges, v);
+    if (it != edges.end() && it->first == v)
+        edges.erase(it);
+}
+
+// Copy of `edges' in the current arena, with room for `extra' more
+ScratchVector<Edge> copy(const Edges &edges, size_t extra = 0) {
+    ScratchVector<Edge> ret(edges.size() + extra);
+    for (const Edge &e : edges)
+        ret.push_back(e);
+    return ret;
+}
+
+} // namespace
+
+SplitZoneDomain::SplitZoneDomain(std::shared_ptr<const VarEnv> env,
+                                 bool isInitialization)
+    : _env(std::move(env)) {
+    n = _env->size();
+    // All variables are zero, which the intervals alone already say. Bottom
+    // has the same lists, so that copies keep their storage.
+    _lower.assign(n, 0);
+    _upper.assign(n, 0);
+    _succ.resize(n);
+    _pred.resize(n);
+    _bottom = !isInitialization;
+}
+
+DBM::Value SplitZoneDomain::weight(size_t u, size_t v) const {
+    auto it = lookup(_succ[u], v);
+    if (it != _succ[u].end() && it->first == v)
+        return it->second;
+    return INF;
+}
+
+void SplitZoneDomain::setEdge(size_t u, size_t v, Value w) {
+    store(_succ[u], v, w);
+    store(_pred[v], u, w);
+}
+
+void SplitZoneDomain::prune(size_t v) {
+    Edges &succ = _succ[v];
+    for (size_t k = 0; k < succ.size();) {
+        auto [t, w] = succ[k];
+        if (w >= implied(v, t)) {
+            erase(_pred[t], v);
+            succ.erase(succ.begin() + k);
+        } else
+            k++;
+    }
+    Edges &pred = _pred[v];
+    for (size_t k = 0; k < pred.size();) {
+        auto [u, w] = pred[k];
+        if (w >= implied(u, v)) {
+            erase(_succ[u], v);
+            pred.erase(pred.begin() + k);
+        } else
+            k++;
+    }
+}
+
+void SplitZoneDomain::setBottom() {
+    _bottom = true;
+    for (size_t v = 0; v < n; v++) {
+        _succ[v].clear();
+        _pred[v].clear();
+    }
+}
+
+bool SplitZoneDomain::addConstraint(size_t i, size_t j, long long c) {
+    if (i == 0)
+        return tightenUpper(j, c);
+    if (j == 0)
+        return tightenLower(i, -c);
+
+    Value w = DBM::bound(c);
+    if (w >= get(i, j))
+        return true;
+    if (DBM::add(w, get(j, i)) < 0) {
+        setBottom();
+        return false;
+    }
+
+    // A shortest path through the new edge starts at a predecessor of `i' and
+    // ends at a successor of `j', any other hop is already in the closed graph
+    // or implied by the intervals
+    ScratchArena::Frame frame;
+    ScratchVector<Edge> src = copy(_pred[i], 1), dst = copy(_succ[j], 1);
+    src.push_back({(uint32_t)i, 0});
+    dst.push_back({(uint32_t)j, 0});
+
+    for (auto [u, du] : src)
+        for (auto [v, dv] : dst) {
+            if (u == v)
+                continue;
+            Value uv = DBM::add(DBM::add(du, w), dv);
+            if (uv < get(u, v))
+                setEdge(u, v, uv);
+        }
+
+    long long ui = _upper[i], lj = _lower[j];
+    for (auto [v, dv] : dst)
+        _upper[v] = DBM::bound(std::min<long long>(_upper[v], ui + w + dv));
+    for (auto [u, du] : src)
+        _lower[u] = DBM::bound(std::max<long long>(_lower[u], lj - w - du));
+
+    for (const ScratchVector<Edge> *edges : {&src, &dst})
+        for (auto [v, _] : *edges)
+            if (_lower[v] > _upper[v]) {
+                setBottom();
+                return false;
+            }
+    for (const ScratchVector<Edge> *edges : {&src, &dst})
+        for (auto [v, _] : *edges)
+            prune(v);
+
+    return true;
+}
+
+bool SplitZoneDomain::tightenUpper(size_t v, long long c) {
+    if (c >= _upper[v])
+        return true;
+    if (c < _lower[v]) {
+        setBottom();
+        return false;
+    }
+
+    _upper[v] = DBM::bound(c);
+    ScratchArena::Frame frame;
+    ScratchVector<Edge> succ = copy(_succ[v]);
+    for (auto [t, w] : succ) {
+        _upper[t] = DBM::bound(std::min<long long>(_upper[t], c + w));
+        if (_upper[t] < _lower[t]) {
+            setBottom();
+            return false;
+        }
+    }
+
+    prune(v);
+    for (auto [t, _] : succ)
+        prune(t);
+
+    return true;
+}
+
+bool SplitZoneDomain::tightenLower(size_t v, long long c) {
+    if (c <= _lower[v])
+        return true;
+    if (c > _upper[v]) {
+        setBottom();
+        return false;
+    }
+
+    _lower[v] = DBM::bound(c);
+    ScratchArena::Frame frame;
+    ScratchVector<Edge> pred = copy(_pred[v]);
+    for (auto [u, w] : pred) {
+        _lower[u] = DBM::bound(std::max<long long>(_lower[u], c - w));
+        if (_lower[u] > _upper[u]) {
+            setBottom();
+            return false;
+        }
+    }
+
+    prune(v);
+    for (auto [u, _] : pred)
+        prune(u);
+
+    return true;
+}
+
+bool SplitZoneDomain::closeVar(size_t v) {
+    if (_lower[v] > _upper[v]) {
+        setBottom();
+        return false;
+    }
+
+    // Paths that are not already closed pass `v' exactly once
+    ScratchArena::Frame frame;
+    ScratchVector<Edge> src = copy(_pred[v]), dst = copy(_succ[v]);
+    for (auto [u, du] : src)
+        for (auto [t, dt] : dst) {
+            Value ut = DBM::add(du, dt);
+            if (u == t) {
+                if (ut < 0) {
+                    setBottom();
+                    return false;
+                }
+                continue;
+            }
+            if (ut < get(u, t))
+                setEdge(u, t, ut);
+        }
+
+    long long uv = _upper[v], lv = _lower[v];
+    for (auto [t, dt] : dst)
+        _upper[t] = DBM::bound(std::min<long long>(_upper[t], uv + dt));
+    for (auto [u, du] : src)
+        _lower[u] = DBM::bound(std::max<long long>(_lower[u], lv - du));
+
+    for (const ScratchVector<Edge> *edges : {&src, &dst})
+        for (auto [u, _] : *edges)
+            if (_lower[u] > _upper[u]) {
+                setBottom();
+                return false;
+            }
+    prune(v);
+    for (const ScratchVector<Edge> *edges : {&src, &dst})
+        for (auto [u, _] : *edges)
+            prune(u);
+
+    return true;
+}
+
+void SplitZoneDomain::havoc(size_t k) {
+    for (auto [t, _] : _succ[k])
+        erase(_pred[t], k);
+    for (auto [u, _] : _pred[k])
+        erase(_succ[u], k);
+    _succ[k].clear();
+    _pred[k].clear();
+    _lower[k] = 0;
+    _upper[k] = 255;
+}
+
+void SplitZoneDomain::dump(std::ostream &out) const {
+    if (isEmpty()) {
+        out << "; Unreachable" << std::endl;
+        return;
+    }
+
+    for (size_t i = 1; i < n; i++) {
+        std::string x = getVar(i);
+        IntervalDomain interval = this->projection(x);
+        out << "; " << x << " = [" << interval.l << ", " << interval.r << "]"
+            << std::endl;
+    }
+
+    // Same as the normal form of `ZoneDomain'
+    for (size_t i = 1; i < n; i++) {
+        std::string x = getVar(i);
+        for (size_t j = 1; j < n; j++) {
+            if (i == j)
+                continue;
+            std::string y = getVar(j);
+            long long c = get(i, j);
+            if (c >= INF)
+                continue;
+            out << "; ";
+            out << x << " ";
+            out << "- " << y << " ";
+            out << "<= " << c << std::endl;
+        }
+    }
+}
+
+bool SplitZoneDomain::leq(const SplitZoneDomain &o) const {
+    if (this->isEmpty())
+        return true;
+    if (o.isEmpty())
+        return false;
+
+    for (size_t v = 1; v < n; v++)
+        if (_lower[v] < o._lower[v] || _upper[v] > o._upper[v])
+            return false;
+
+    // Bounds implied by `o' are looser than the ones implied by `*this'
+    for (size_t u = 1; u < n; u++)
+        for (auto [v, w] : o._succ[u])
+            if (get(u, v) > w)
+                return false;
+    return true;
+}
+
+bool SplitZoneDomain::eq(const SplitZoneDomain &o) const {
+    if (this->isEmpty() || o.isEmpty())
+        return this->_bottom == o._bottom;
+    // The split normal form is unique
+    return _lower == o._lower && _upper == o._upper && _succ == o._succ;
+}
+
+IntervalDomain SplitZoneDomain::projection(const std::string &x) const {
+    return projection(getID(x));
+}
+
+IntervalDomain SplitZoneDomain::projection(size_t x) const {
+    if (isEmpty())
+        return IntervalDomain(INF, -INF);
+    return IntervalDomain(_lower[x], _upper[x]);
+}
+
+SplitZoneDomain SplitZoneDomain::lub(const SplitZoneDomain &o) const {
+    if (this->isEmpty())
+        return o;
+    if (o.isEmpty())
+        return *this;
+
+    SplitZoneDomain ret;
+    ret._env = _env;
+    lubInto(o, ret);
+    return ret;
+}
+
+void SplitZoneDomain::lubInto(const SplitZoneDomain &o,
+                              SplitZoneDomain &ret) const {
+    const SplitZoneDomain &a = *this, &b = o;
+    ret.n = n;
+    ret._bottom = false;
+    ret._lower.resize(n);
+    ret._upper.resize(n);
+    ret._succ.resize(n);
+    ret._pred.resize(n);
+    for (size_t v = 0; v < n; v++) {
+        ret._lower[v] = std::min(a._lower[v], b._lower[v]);
+        ret._upper[v] = std::max(a._upper[v], b._upper[v]);
+        ret._succ[v].clear();
+        ret._pred[v].clear();
+    }
+
+    // Relations kept by either side, visited in order so that the adjacency
+    // stays sorted
+    for (size_t u = 1; u < n; u++) {
+        const Edges &ea = a._succ[u], &eb = b._succ[u];
+        auto ia = ea.begin(), ib = eb.begin();
+        while (ia != ea.end() || ib != eb.end()) {
+            size_t v;
+            if (ib == eb.end() || (ia != ea.end() && ia->first < ib->first))
+                v = (ia++)->first;
+            else if (ia == ea.end() || ib->first < ia->first)
+                v = (ib++)->first;
+            else {
+                v = ia->first;
+                ia++, ib++;
+            }
+            Value w = std::max(a.get(u, v), b.get(u, v));
+            if (w < ret.implied(u, v)) {
+                ret._succ[u].emplace_back(v, w);
+                ret._pred[v].emplace_back(u, w);
+            }
+        }
+    }
+
+    // A relation implied on both sides is new when the lower bound of `u' and
+    // the upper bound of `v' come from different sides
+    ScratchArena::Frame frame;
+    ScratchVector<size_t> lowerA(n), lowerB(n), upperA(n), upperB(n);
+    for (size_t v = 1; v < n; v++) {
+        if (a._lower[v] != b._lower[v])
+            (a._lower[v] < b._lower[v] ? lowerA : lowerB).push_back(v);
+        if (a._upper[v] != b._upper[v])
+            (a._upper[v] > b._upper[v] ? upperA : upperB).push_back(v);
+    }
+    auto joinImplied = [&](const ScratchVector<size_t> &us,
+                           const ScratchVector<size_t> &vs) {
+        for (size_t u : us)
+            for (size_t v : vs) {
+                if (u == v || a.weight(u, v) < INF || b.weight(u, v) < INF)
+                    continue;
+                Value w = std::max(a.implied(u, v), b.implied(u, v));
+                if (w < ret.implied(u, v))
+                    ret.setEdge(u, v, w);
+            }
+    };
+    joinImplied(lowerA, upperB);
+    joinImplied(lowerB, upperA);
+}
+
+SplitZoneDomain
+SplitZoneDomain::widen(const SplitZoneDomain &o,
+                       const std::vector<long long> &thresholds) const {
+    SplitZoneDomain ret = *this;
+    ret.widenWith(o, thresholds);
+    return ret;
+}
+
+namespace {
+
+// Join computed before it is copied into a zone, shared by all split zones
+// of the thread so that its lists keep their storage
+SplitZoneDomain &joinScratch() {
+    static thread_local SplitZoneDomain joined;
+    return joined;
+}
+
+} // namespace
+
+void SplitZoneDomain::joinWith(const SplitZoneDomain &o) {
+    if (o.isEmpty())
+        return;
+    if (this->isEmpty()) {
+        *this = o;
+        return;
+    }
+
+    SplitZoneDomain &joined = joinScratch();
+    lubInto(o, joined);
+    _lower = joined._lower;
+    _upper = joined._upper;
+    _succ = joined._succ;
+    _pred = joined._pred;
+}
+
+void SplitZoneDomain::widenWith(const SplitZoneDomain &o,
+                                const std::vector<long long> &thresholds) {
+    if (this->isEmpty()) {
+        *this = o;
+        return;
+    }
+    if (o.isEmpty())
+        return;
+
+    SplitZoneDomain &joined = joinScratch();
+    lubInto(o, joined);
+
+    // The stable relations are closed again one by one. Only the stored edges
+    // are needed: a relation that `joined' only implies by the lower bound of
+    // `u' and the upper bound of `v' is looser than in `*this' as soon as one
+    // of them moved, so it is unstable and `ZoneDomain' drops it as well.
+    struct Stable {
+        size_t u, v;
+        Value w;
+    };
+    size_t edges = 0;
+    for (size_t u = 1; u < n; u++)
+        edges += joined._succ[u].size();
+    ScratchArena::Frame frame;
+    ScratchVector<Stable> stable(edges);
+    for (size_t u = 1; u < n; u++)
+        for (auto [v, w] : joined._succ[u])
+            if (w <= get(u, v))
+                stable.push_back({u, v, w});
+
+    for (size_t v = 1; v < n; v++) {
+        if (joined._upper[v] > _upper[v])
+            _upper[v] = DBM::bound(widenUpper(thresholds, joined._upper[v]));
+        else
+            _upper[v] = joined._upper[v];
+        if (joined._lower[v] < _lower[v])
+            _lower[v] = DBM::bound(widenLower(thresholds, joined._lower[v]));
+        else
+            _lower[v] = joined._lower[v];
+        _succ[v].clear();
+        _pred[v].clear();
+    }
+    for (auto [u, v, w] : stable)
+        addConstraint(u, v, w);
+}
+
+SplitZoneDomain SplitZoneDomain::forget(const std::string &x) const {
+    SplitZoneDomain ret = *this;
+    ret.forget(getID(x));
+    return ret;
+}
+
+void SplitZoneDomain::forget(size_t x) {
+    if (!this->isEmpty())
+        havoc(x);
+}
+
+SplitZoneDomain SplitZoneDomain::filter(const std::string &x,
+                                        const std::string &y,
+                                        long long c) const {
+    SplitZoneDomain ret = *this;
+    ret.filter(getID(x), getID(y), c);
+    return ret;
+}
+
+void SplitZoneDomain::filter(size_t x, size_t y, long long c) {
+    if (!this->isEmpty())
+        addConstraint(y, x, c);
+}
+
+SplitZoneDomain SplitZoneDomain::assign_case1(const std::string &x,
+                                              long long c) const {
+    SplitZoneDomain ret = *this;
+    ret.assign(getID(x), getID(x), c);
+    return ret;
+}
+
+SplitZoneDomain SplitZoneDomain::assign_case2(const std::string &x,
+                                              const std::string &y,
+                                              long long c) const {
+    SplitZoneDomain ret = *this;
+    ret.assign(getID(x), getID(y), c);
+    return ret;
+}
+
+void SplitZoneDomain::assign(size_t x, size_t y, long long c) {
+    if (this->isEmpty())
+        return;
+    size_t i0 = x;
+
+    if (y == x) {
+        // Same saturation as `ZoneDomain::assign'
+        long long pc = c;
+        pc = std::min(pc, 255ll - _upper[i0]);
+        pc = std::max(pc, -(long long)_upper[i0]);
+        long long mc = c;
+        mc = std::min(mc, 255ll - _lower[i0]);
+        mc = std::max(mc, -(long long)_lower[i0]);
+
+        // Edges only bound `x' against other variables
+        for (auto &[t, w] : _succ[i0]) {
+            DBM::Value in = DBM::INF;
+            if (pc == mc)
+                w = DBM::add(w, DBM::bound(-pc));
+            else
+                shiftSaturated(in, w, c, _lower[t], _upper[t]);
+            lookup(_pred[t], i0)->second = w;
+        }
+        for (auto &[u, w] : _pred[i0]) {
+            DBM::Value out = DBM::INF;
+            if (pc == mc)
+                w = DBM::add(w, DBM::bound(pc));
+            else
+                shiftSaturated(w, out, c, _lower[u], _upper[u]);
+            lookup(_succ[u], i0)->second = w;
+        }
+        _lower[i0] = DBM::bound(_lower[i0] + mc);
+        _upper[i0] = DBM::bound(_upper[i0] + pc);
+
+        if (pc != mc)
+            closeVar(i0);
+        return;
+    }
+
+    size_t j0 = y;
+    havoc(i0);
+    if (addConstraint(j0, i0, c))
+        addConstraint(i0, j0, -c);
+}
+
+SplitZoneDomain SplitZoneDomain::assign_case3(const std::string &x,
+                                              long long l, long long r) const {
+    SplitZoneDomain ret = *this;
+    ret.assignInterval(getID(x), l, r);
+    return ret;
+}
+
+void SplitZoneDomain::assignInterval(size_t x, long long l, long long r) {
+    l = std::max(l, 0ll);
+    r = std::min(r, 255ll);
+
+    if (this->isEmpty())
+        return;
+
+    havoc(x);
+    if (tightenLower(x, l))
+        tightenUpper(x, r);
+}
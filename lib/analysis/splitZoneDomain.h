@@ -0,0 +1,250 @@
+#ifndef ANALYSIS_SPLITZONEDOMAIN_H
+#define ANALYSIS_SPLITZONEDOMAIN_H
+
+#include "IR/IR.h"
+#include "dbm.h"
+#include "scratchArena.h"
+#include "zoneTransfer.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fdlang::analysis {
+
+/**
+ * Zone in split normal form
+ *
+ * The interval of every variable is kept apart from a sparse graph of
+ * difference constraints. An edge `u -> v' of weight `w' stands for
+ * `var_v - var_u <= w' and is only stored while it is tighter than
+ * `_upper[v] - _lower[u]', the bound the intervals already imply, so memory
+ * and time scale with the number of actual relations instead of n^2.
+ *
+ * The zone is kept closed: with the implied bounds filled in, the matrix is
+ * the normal form of `ZoneDomain'. A new constraint `u -> v' then only has to
+ * be combined with the predecessors of `u' and the successors of `v', like a
+ * single step of an incremental Dijkstra, and only their bounds can change.
+ *
+ * Bottom keeps its adjacency lists, and the in-place operations copy into the
+ * storage a zone already has, taking their temporaries from the current
+ * `ScratchArena', so a fixpoint stops allocating once the lists have grown.
+ */
+class SplitZoneDomain : public ZoneTransfer<SplitZoneDomain> {
+private:
+    using Value = DBM::Value;
+    static const long long INF;
+    size_t n = 0;
+
+    std::shared_ptr<const VarEnv> _env;
+
+    // var_i in [_lower[i], _upper[i]], index 0 is the constant zero
+    std::vector<Value> _lower, _upper;
+
+    // (target, weight) sorted by target, `_pred' mirrors `_succ'
+    using Edge = std::pair<uint32_t, Value>;
+    using Edges = std::vector<Edge>;
+    std::vector<Edges> _succ, _pred;
+
+    bool _bottom = false;
+
+    const std::string &getVar(size_t id) const { return _env->getVar(id); }
+
+    size_t getID(const std::string &x) const { return _env->getID(x); }
+
+    /**
+     * @brief Get the stored weight of `u -> v', INF if there is none
+     */
+    Value weight(size_t u, size_t v) const;
+
+    /**
+     * @brief Get the bound of `var_v - var_u' implied by the intervals
+     */
+    Value implied(size_t u, size_t v) const {
+        return DBM::bound((long long)_upper[v] - _lower[u]);
+    }
+
+    /**
+     * @brief Get the bound of `var_v - var_u', as `_dbm[u][v]' of `ZoneDomain'
+     */
+    Value get(size_t u, size_t v) const {
+        return u == v ? 0 : std::min(weight(u, v), implied(u, v));
+    }
+
+    void setEdge(size_t u, size_t v, Value w);
+
+    /**
+     * @brief Drop the edges of `v' that its interval makes redundant
+     */
+    void prune(size_t v);
+
+    void setBottom();
+
+    /**
+     * @brief Compute in `ret' the least upper bound of `*this' and `o', which
+     * are not bottom, reusing the storage of `ret'
+     */
+    void lubInto(const SplitZoneDomain &o, SplitZoneDomain &ret) const;
+
+    /**
+     * @brief Add `var_j - var_i <= c' and restore the closure
+     *
+     * Return false and turn `*this' into bottom on a negative cycle.
+     */
+    bool addConstraint(size_t i, size_t j, long long c);
+
+    /**
+     * @brief Add `var_v <= c' and restore the closure
+     */
+    bool tightenUpper(size_t v, long long c);
+
+    /**
+     * @brief Add `var_v >= c' and restore the closure
+     */
+    bool tightenLower(size_t v, long long c);
+
+    /**
+     * @brief Restore the closure after tightening the edges of `v'
+     *
+     * Assume the rest of the graph is closed.
+     */
+    bool closeVar(size_t v);
+
+    /**
+     * @brief Drop every constraint on `k' except `0 <= k <= 255'
+     */
+    void havoc(size_t k);
+
+public:
+    /**
+     * @brief Construct a new Split Zone Domain
+     *
+     * @param vars symbols of appeared variables
+     * @param isInitialization true for initialization(all zero) and false for
+     * bottom
+     */
+    SplitZoneDomain(const std::vector<Symbol> &vars,
+                    bool isInitialization)
+        : SplitZoneDomain(std::make_shared<const VarEnv>(vars),
+                          isInitialization) {}
+    SplitZoneDomain(std::shared_ptr<const VarEnv> env, bool isInitialization);
+    SplitZoneDomain() = default;
+
+    const VarEnv &env() const { return *_env; }
+
+    void dump(std::ostream &out) const;
+
+    /**
+     * @brief Test if `*this' is bottom
+     */
+    bool isEmpty() const { return _bottom; }
+
+    /**
+     * @brief Test if `*this' is less or equal than `o' in partial order <=
+     */
+    bool leq(const SplitZoneDomain &o) const;
+
+    /**
+     * @brief Test if `*this' is equal to `o'
+     */
+    bool eq(const SplitZoneDomain &o) const;
+
+    /**
+     * @brief Get the projection of `*this' on the variable `x'
+     */
+    IntervalDomain projection(const std::string &x) const;
+
+    /**
+     * @brief Get the new zone which is the least upper bound of `*this' and `o'
+     */
+    SplitZoneDomain lub(const SplitZoneDomain &o) const;
+
+    /**
+     * @brief Get the new zone which widens `*this' with `o'
+     *
+     * Unstable bounds jump to the next of the sorted `thresholds', unstable
+     * relations between variables are dropped.
+     */
+    SplitZoneDomain widen(const SplitZoneDomain &o,
+                          const std::vector<long long> &thresholds) const;
+
+    /**
+     * @brief Get the new zone which forgets the variable `x'
+     */
+    SplitZoneDomain forget(const std::string &x) const;
+
+    /**
+     * @brief Get the new zone filtered by guard `x - y <= c'
+     *
+     * For case `x <= c', we set y = ""
+     * For case `-y <= c', we set x = ""
+     */
+    SplitZoneDomain filter(const std::string &x, const std::string &y,
+                           long long c) const;
+
+    /**
+     * @brief Get the new zone after excuting `x = x + c'
+     */
+    SplitZoneDomain assign_case1(const std::string &x, long long c) const;
+
+    /**
+     * @brief Get the new zone after excuting `x = y + c' or `x = c'
+     *
+     * For case `x = c', we set y = ""
+     */
+    SplitZoneDomain assign_case2(const std::string &x, const std::string &y,
+                                 long long c) const;
+
+    /**
+     * @brief Get the new zone after excuting `x = [l, r]'
+     */
+    SplitZoneDomain assign_case3(const std::string &x, long long l,
+                                 long long r) const;
+
+    // In-place operations on the variable ids of `env()', where 0 is the
+    // constant zero
+
+    /**
+     * @brief Get the projection of `*this' on the variable `x'
+     */
+    IntervalDomain projection(size_t x) const;
+
+    /**
+     * @brief Join `o' into `*this'
+     */
+    void joinWith(const SplitZoneDomain &o);
+
+    /**
+     * @brief Widen `*this' with `o', see `widen'
+     */
+    void widenWith(const SplitZoneDomain &o,
+                   const std::vector<long long> &thresholds);
+
+    /**
+     * @brief Forget the variable `x'
+     */
+    void forget(size_t x);
+
+    /**
+     * @brief Filter by guard `x - y <= c'
+     */
+    void filter(size_t x, size_t y, long long c);
+
+    /**
+     * @brief Excute `x = y + c'
+     *
+     * It is `x = x + c' for y == x and `x = c' for y == 0.
+     */
+    void assign(size_t x, size_t y, long long c);
+
+    /**
+     * @brief Excute `x = [l, r]'
+     */
+    void assignInterval(size_t x, long long l, long long r);
+};
+
+} // namespace fdlang::analysis
+
+#endif
@@ -0,0 +1,63 @@
+#include "threadPool.h"
+
+using namespace fdlang::analysis;
+
+ThreadPool::ThreadPool(size_t threads) {
+    for (size_t i = 1; i < threads; i++)
+        workers.emplace_back([this] { work(); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+}
+
+void ThreadPool::work() {
+    std::unique_lock<std::mutex> lock(mutex);
+    size_t seen = generation;
+    while (true) {
+        wakeUp.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping)
+            return;
+        seen = generation;
+        drain(lock);
+    }
+}
+
+void ThreadPool::drain(std::unique_lock<std::mutex> &lock) {
+    while (next < count) {
+        size_t i = next++;
+        const std::function<void(size_t)> &fn = *job;
+        lock.unlock();
+        fn(i);
+        lock.lock();
+        if (--remaining == 0)
+            finished.notify_all();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count,
+                             const std::function<void(size_t)> &fn) {
+    if (workers.empty() || count <= 1) {
+        for (size_t i = 0; i < count; i++)
+            fn(i);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    job = &fn;
+    next = 0;
+    this->count = remaining = count;
+    generation++;
+    wakeUp.notify_all();
+
+    drain(lock);
+    finished.wait(lock, [&] { return remaining == 0; });
+    job = nullptr;
+    this->count = 0;
+}
@@ -0,0 +1,57 @@
+#ifndef ANALYSIS_THREADPOOL_H
+#define ANALYSIS_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fdlang::analysis {
+
+/**
+ * Fixed set of threads running the iterations of one loop at a time
+ *
+ * The calling thread takes part in the loop, so a pool of size 1 has no
+ * worker and runs everything inline.
+ */
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable wakeUp, finished;
+
+    // The loop being run, and its next and unfinished iterations
+    const std::function<void(size_t)> *job = nullptr;
+    size_t next = 0, count = 0, remaining = 0;
+    // Bumped for every loop, so that workers tell a new loop from a spurious
+    // wake up
+    size_t generation = 0;
+    bool stopping = false;
+
+    void work();
+
+    /**
+     * @brief Run iterations of the current loop until none is left
+     */
+    void drain(std::unique_lock<std::mutex> &lock);
+
+public:
+    explicit ThreadPool(size_t threads);
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ~ThreadPool();
+
+    size_t size() const { return workers.size() + 1; }
+
+    /**
+     * @brief Run `fn(i)' for every i in [0, count) and wait for all of them
+     */
+    void parallelFor(size_t count, const std::function<void(size_t)> &fn);
+};
+
+} // namespace fdlang::analysis
+
+#endif
@@ -0,0 +1,150 @@
+#include "valueSet.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace fdlang::analysis;
+
+ValueSet::ValueSet(int s, int e) {
+    s = std::max(s, MIN);
+    e = std::min(e, MAX);
+    for (int i = 0; i < (int)WORDS; i++) {
+        // Bits of [s, e] in the word of [64i, 64i + 63]
+        int l = std::max(s, 64 * i), r = std::min(e, 64 * i + 63);
+        if (l > r)
+            continue;
+        uint64_t upTo = r % 64 == 63 ? ~0ull : (1ull << (r % 64 + 1)) - 1;
+        w[i] = upTo & ~((1ull << (l % 64)) - 1);
+    }
+}
+
+int ValueSet::next(int from, bool value) const {
+    for (int i = from / 64; i < (int)WORDS; i++) {
+        uint64_t bits = value ? w[i] : ~w[i];
+        if (i == from / 64)
+            bits &= ~0ull << (from % 64);
+        if (bits)
+            return 64 * i + __builtin_ctzll(bits);
+    }
+    return MAX + 1;
+}
+
+int ValueSet::max() const {
+    for (int i = WORDS - 1; i >= 0; i--)
+        if (w[i])
+            return 64 * i + 63 - __builtin_clzll(w[i]);
+    return MIN - 1;
+}
+
+bool ValueSet::widenWith(const ValueSet &o,
+                         const std::vector<long long> &thresholds) {
+    if (o.subsetOf(*this))
+        return false;
+    if (isEmpty()) {
+        *this = o;
+        return true;
+    }
+
+    long long l = min(), r = max();
+    if (o.min() < l) {
+        auto it = std::upper_bound(thresholds.begin(), thresholds.end(),
+                                   (long long)o.min());
+        l = it == thresholds.begin() ? MIN : *--it;
+    }
+    if (o.max() > r) {
+        auto it = std::lower_bound(thresholds.begin(), thresholds.end(),
+                                   (long long)o.max());
+        r = it == thresholds.end() ? MAX : *it;
+    }
+    *this = ValueSet(std::max<long long>(l, MIN), std::min<long long>(r, MAX));
+    return true;
+}
+
+ValueSet ValueSet::add(int c) const {
+    if (c == 0 || isEmpty())
+        return *this;
+
+    ValueSet ret;
+    if (c > MAX - MIN || -c > MAX - MIN) {
+        ret.w[c > 0 ? WORDS - 1 : 0] = c > 0 ? 1ull << 63 : 1;
+        return ret;
+    }
+
+    int k = std::abs(c), words = k / 64, bits = k % 64;
+    for (int i = 0; i < (int)WORDS; i++) {
+        // Word `i' of the result comes from words `from' and `from -+ 1'
+        int from = c > 0 ? i - words : i + words;
+        if (from < 0 || from >= (int)WORDS)
+            continue;
+        if (c > 0) {
+            ret.w[i] = w[from] << bits;
+            if (bits && from > 0)
+                ret.w[i] |= w[from - 1] >> (64 - bits);
+        } else {
+            ret.w[i] = w[from] >> bits;
+            if (bits && from + 1 < (int)WORDS)
+                ret.w[i] |= w[from + 1] << (64 - bits);
+        }
+    }
+
+    // Values shifted out saturate
+    if (c > 0 && max() > MAX - c)
+        ret.w[WORDS - 1] |= 1ull << 63;
+    if (c < 0 && min() < MIN - c)
+        ret.w[0] |= 1;
+    return ret;
+}
+
+ValueSet ValueSet::spreadUp(int len) const {
+    // Shifts by 0..covered are in `ret', one more step of at most
+    // `covered + 1' leaves no gap
+    ValueSet ret = *this;
+    for (int covered = 0; covered < len;) {
+        int step = std::min(covered + 1, len - covered);
+        ret.joinWith(ret.add(step));
+        covered += step;
+    }
+    return ret;
+}
+
+ValueSet ValueSet::spreadDown(int len) const {
+    ValueSet ret = *this;
+    for (int covered = 0; covered < len;) {
+        int step = std::min(covered + 1, len - covered);
+        ret.joinWith(ret.add(-step));
+        covered += step;
+    }
+    return ret;
+}
+
+// Saturation composes: min(MAX, min(MAX, x + a) + d) = min(MAX, x + a + d)
+// for a, d >= 0, and alike for the differences, so every run of `o' is a
+// shift followed by a spread
+
+ValueSet ValueSet::add(const ValueSet &o) const {
+    ValueSet ret;
+    for (int a = o.min(); a <= MAX;) {
+        int b = o.next(a, false) - 1;
+        ret.joinWith(add(a).spreadUp(b - a));
+        a = o.next(b + 1, true);
+    }
+    return ret;
+}
+
+ValueSet ValueSet::sub(const ValueSet &o) const {
+    ValueSet ret;
+    for (int a = o.min(); a <= MAX;) {
+        int b = o.next(a, false) - 1;
+        ret.joinWith(add(-a).spreadDown(b - a));
+        a = o.next(b + 1, true);
+    }
+    return ret;
+}
+
+void ValueSet::dump(std::ostream &out) const {
+    for (int s = min(); s <= MAX;) {
+        int e = next(s, false) - 1;
+        out << "[" << s << ", " << e << "]";
+        s = next(e + 1, true);
+    }
+}
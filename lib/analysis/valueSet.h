@@ -0,0 +1,164 @@
+#ifndef ANALYSIS_VALUESET_H
+#define ANALYSIS_VALUESET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace fdlang::analysis {
+
+/**
+ * Set of FDlang values, one bit for each of [0, 255]
+ *
+ * The 256 bits fill four words, so the set operations are a few word
+ * operations which the compiler turns into vector ones, and copies never
+ * touch the heap. The arithmetic is exact and saturates like FDlang: sums
+ * stop at 255 and differences at 0.
+ */
+class ValueSet {
+public:
+    static constexpr int MIN = 0;
+    static constexpr int MAX = 255;
+
+private:
+    static constexpr size_t WORDS = 4;
+
+    alignas(32) uint64_t w[WORDS] = {};
+
+    /**
+     * @brief Get the first value from `from' on which is in the set if
+     * `value', or out of it otherwise, MAX + 1 if there is none
+     */
+    int next(int from, bool value) const;
+
+    /**
+     * @brief Get the union of `*this' shifted up by every `0..len'
+     */
+    ValueSet spreadUp(int len) const;
+
+    /**
+     * @brief Get the union of `*this' shifted down by every `0..len'
+     */
+    ValueSet spreadDown(int len) const;
+
+public:
+    /**
+     * @brief Construct the empty set
+     */
+    ValueSet() = default;
+
+    /**
+     * @brief Construct the set of [s, e], clipped to [MIN, MAX]
+     */
+    ValueSet(int s, int e);
+
+    bool isEmpty() const { return (w[0] | w[1] | w[2] | w[3]) == 0; }
+
+    bool contains(int v) const {
+        return MIN <= v && v <= MAX && (w[v / 64] >> (v % 64) & 1);
+    }
+
+    /**
+     * @brief Get the least value, MAX + 1 for the empty set
+     */
+    int min() const { return next(MIN, true); }
+
+    /**
+     * @brief Get the largest value, MIN - 1 for the empty set
+     */
+    int max() const;
+
+    bool operator==(const ValueSet &o) const {
+        return ((w[0] ^ o.w[0]) | (w[1] ^ o.w[1]) | (w[2] ^ o.w[2]) |
+                (w[3] ^ o.w[3])) == 0;
+    }
+
+    bool operator!=(const ValueSet &o) const { return !(*this == o); }
+
+    size_t hash() const {
+        uint64_t h = w[0];
+        for (size_t i = 1; i < WORDS; i++)
+            h = (h ^ (h >> 29)) * 0x9e3779b97f4a7c15ull + w[i];
+        return h ^ (h >> 32);
+    }
+
+    /**
+     * @brief Test if every value of `*this' is in `o'
+     */
+    bool subsetOf(const ValueSet &o) const {
+        return ((w[0] & ~o.w[0]) | (w[1] & ~o.w[1]) | (w[2] & ~o.w[2]) |
+                (w[3] & ~o.w[3])) == 0;
+    }
+
+    /**
+     * @brief Add the values of `o', return true if `*this' changed
+     */
+    bool joinWith(const ValueSet &o) {
+        ValueSet old = *this;
+        for (size_t i = 0; i < WORDS; i++)
+            w[i] |= o.w[i];
+        return *this != old;
+    }
+
+    /**
+     * @brief Keep the values of `o', return true if `*this' changed
+     */
+    bool meetWith(const ValueSet &o) {
+        ValueSet old = *this;
+        for (size_t i = 0; i < WORDS; i++)
+            w[i] &= o.w[i];
+        return *this != old;
+    }
+
+    /**
+     * @brief Drop the values of `o', return true if `*this' changed
+     */
+    bool remove(const ValueSet &o) {
+        ValueSet old = *this;
+        for (size_t i = 0; i < WORDS; i++)
+            w[i] &= ~o.w[i];
+        return *this != old;
+    }
+
+    /**
+     * @brief Widen `*this' with `o', return true if `*this' changed
+     *
+     * Unless `o' is included, the result is the hull of both sides, where
+     * the bounds which moved jump to the next of the sorted `thresholds', or
+     * to MIN and MAX. Chains of widenings are then as long as the thresholds,
+     * whatever the values reached.
+     */
+    bool widenWith(const ValueSet &o,
+                   const std::vector<long long> &thresholds);
+
+    /**
+     * @brief Get `{ x + c }' for the values x, saturated to [MIN, MAX]
+     *
+     * It is a shift of the words, and the values shifted out are put back at
+     * the bound they cross.
+     */
+    ValueSet add(int c) const;
+
+    /**
+     * @brief Get `{ x + y }' for x in `*this' and y in `o', saturated to MAX
+     *
+     * Every run [a, b] of `o' shifts `*this' by a, then ORs it with itself
+     * shifted by doubling steps until b is covered.
+     */
+    ValueSet add(const ValueSet &o) const;
+
+    /**
+     * @brief Get `{ x - y }' for x in `*this' and y in `o', saturated to MIN
+     */
+    ValueSet sub(const ValueSet &o) const;
+
+    /**
+     * @brief Print the runs of the set as `[s, e]'
+     */
+    void dump(std::ostream &out) const;
+};
+
+} // namespace fdlang::analysis
+
+#endif
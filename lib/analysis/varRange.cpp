@@ -0,0 +1,60 @@
+#include "varRange.h"
+
+#include <cassert>
+
+using namespace fdlang::analysis;
+
+VarRangePool::VarRangePool(size_t vars) {
+    while ((size_t)1 << (BITS * _levels) < vars)
+        _levels++;
+    value(ValueSet());
+    assert(values.size() == EMPTY + 1);
+}
+
+uint32_t VarRangePool::value(const ValueSet &v) {
+    auto [it, inserted] = valueIds.emplace(v, values.size());
+    if (inserted)
+        values.push_back(v);
+    return it->second;
+}
+
+uint32_t VarRangePool::node(const Node &n) {
+    auto [it, inserted] = nodeIds.emplace(n, nodes.size());
+    if (inserted)
+        nodes.push_back(n);
+    return it->second;
+}
+
+VarRange::VarRange(VarRangePool &pool, const ValueSet &init) : pool(&pool) {
+    // Every node of a level is the same
+    root = pool.value(init);
+    for (size_t level = 0; level < pool.levels(); level++) {
+        VarRangePool::Node n;
+        n.fill(root);
+        root = pool.node(n);
+    }
+}
+
+const ValueSet &VarRange::getVar(size_t id) const {
+    static const ValueSet none;
+    if (!pool || id >> (VarRangePool::BITS * pool->levels()))
+        return none;
+    uint32_t node = root;
+    for (size_t level = pool->levels(); level-- > 0;)
+        node = pool->getNode(node)[slot(id, level)];
+    return pool->getValue(node);
+}
+
+uint32_t VarRange::insert(uint32_t node, size_t level, size_t id,
+                          uint32_t value) {
+    VarRangePool::Node n = pool->getNode(node);
+    size_t i = slot(id, level);
+    n[i] = level == 0 ? value : insert(n[i], level - 1, id, value);
+    return pool->node(n);
+}
+
+void VarRange::insertVar(size_t id, const ValueSet &range) {
+    if (!pool || getVar(id) == range)
+        return;
+    root = insert(root, pool->levels() - 1, id, pool->value(range));
+}
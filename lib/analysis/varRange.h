@@ -0,0 +1,227 @@
+#ifndef ANALYSIS_VARRANGE_H
+#define ANALYSIS_VARRANGE_H
+
+#include "valueSet.h"
+#include "zoneTransfer.h"
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+namespace fdlang::analysis {
+
+/**
+ * Hash-consed nodes of the `VarRange's of an analysis
+ *
+ * A state is a trie over the ids of the variables, `FANOUT' children per
+ * node, whose bottom nodes point to the values of the variables. Values and
+ * nodes are interned, so equal contents always get the same index and two
+ * states are equal iff their roots are. Nodes are never freed before the
+ * pool, which is cheap as a state only adds the path to what it changes.
+ */
+class VarRangePool {
+public:
+    static constexpr size_t BITS = 3;
+    static constexpr size_t FANOUT = 1 << BITS;
+
+    // Children of a node: nodes, or values for the bottom nodes
+    using Node = std::array<uint32_t, FANOUT>;
+
+    // Index of the empty set, interned first
+    static constexpr uint32_t EMPTY = 0;
+
+private:
+    struct NodeHash {
+        size_t operator()(const Node &n) const {
+            uint64_t h = 0;
+            for (uint32_t c : n)
+                h = (h ^ c) * 0x100000001b3ull;
+            return h ^ (h >> 32);
+        }
+    };
+
+    struct ValueSetHash {
+        size_t operator()(const ValueSet &v) const { return v.hash(); }
+    };
+
+    // Levels of nodes above the values
+    size_t _levels = 1;
+
+    // Values stay in place, so references to them are never invalidated
+    std::deque<ValueSet> values;
+    std::unordered_map<ValueSet, uint32_t, ValueSetHash> valueIds;
+
+    std::vector<Node> nodes;
+    std::unordered_map<Node, uint32_t, NodeHash> nodeIds;
+
+public:
+    /**
+     * @brief Construct a pool for the ids [0, vars)
+     */
+    explicit VarRangePool(size_t vars);
+
+    VarRangePool(const VarRangePool &) = delete;
+    VarRangePool &operator=(const VarRangePool &) = delete;
+
+    size_t levels() const { return _levels; }
+
+    /**
+     * @brief Intern `v', return its index
+     */
+    uint32_t value(const ValueSet &v);
+
+    /**
+     * @brief Intern `n', return its index
+     */
+    uint32_t node(const Node &n);
+
+    const ValueSet &getValue(uint32_t i) const { return values[i]; }
+
+    const Node &getNode(uint32_t i) const { return nodes[i]; }
+
+    size_t valueCount() const { return values.size(); }
+
+    size_t nodeCount() const { return nodes.size(); }
+};
+
+/**
+ * Values of the variables of a `VarEnv', indexed by their ids
+ *
+ * It is a persistent map in a `VarRangePool': modifying a state copies the
+ * path to the variable and shares the rest, and the lattice operations skip
+ * the subtrees the two sides share, so equal states compare in O(1). A
+ * default constructed state has no pool and no value.
+ */
+class VarRange {
+private:
+    VarRangePool *pool = nullptr;
+    uint32_t root = 0;
+
+    // child of `node' at `level' on the path to `id'
+    static size_t slot(size_t id, size_t level) {
+        return id >> (VarRangePool::BITS * level) & (VarRangePool::FANOUT - 1);
+    }
+
+    // `node' at `level' with the value of `id' replaced
+    uint32_t insert(uint32_t node, size_t level, size_t id, uint32_t value);
+
+    // `a' at `level' with `op' applied to its values and the ones of `b'
+    template <typename Op>
+    uint32_t combine(uint32_t a, uint32_t b, size_t level, Op &op,
+                     bool idempotent);
+
+    // apply `op' to the values of each variable and the ones of _varRange,
+    // a state without values takes the ones of _varRange. Only when `op' is
+    // idempotent, i.e. op(v, v) leaves v, are shared subtrees skipped
+    // return true if VarRange is changed
+    template <typename Op>
+    bool combine(const VarRange& _varRange, Op op, bool idempotent = true);
+
+public:
+    VarRange() = default;
+
+    // every variable of `pool' has `init'
+    VarRange(VarRangePool& pool, const ValueSet& init);
+
+    // print Range of all variables
+    void print(const VarEnv& env) const {
+        for (size_t id = 1; id < env.size(); id++) {
+            std::cout << env.getVar(id) << ": ";
+            getVar(id).dump(std::cout);
+            std::cout << " ";
+        }
+    }
+
+    // get the values of a variable
+    const ValueSet& getVar(size_t id) const;
+
+    // replace the values of a variable
+    void insertVar(size_t id, const ValueSet& range);
+
+    // union the Range of each variable
+    // return true if VarRange is changed
+    bool range_union(const VarRange& _varRange) {
+        return combine(_varRange, [](ValueSet& v, const ValueSet& o) {
+            return v.joinWith(o);
+        });
+    }
+
+    // join the Range of each variable
+    // return true if VarRange is changed
+    bool range_join(const VarRange& _varRange) {
+        if (!pool) {
+            return false;
+        }
+        return combine(_varRange, [](ValueSet& v, const ValueSet& o) {
+            return v.meetWith(o);
+        });
+    }
+
+    // subtract the Range of each variable
+    // return true if VarRange is changed
+    bool range_subtract(const VarRange& _varRange) {
+        if (!pool) {
+            return false;
+        }
+        return combine(
+            _varRange,
+            [](ValueSet& v, const ValueSet& o) { return v.remove(o); },
+            false);
+    }
+
+    // widen the values of each variable with _VarRange
+    // return true if VarRange is changed
+    bool range_widen(const VarRange& _varRange,
+                     const std::vector<long long>& thresholds) {
+        return combine(_varRange, [&](ValueSet& v, const ValueSet& o) {
+            return v.widenWith(o, thresholds);
+        });
+    }
+
+    // return true if VarRange is equal to _VarRange
+    bool range_equal(const VarRange& _varRange) const {
+        return pool == _varRange.pool && root == _varRange.root;
+    }
+};
+
+template <typename Op>
+uint32_t VarRange::combine(uint32_t a, uint32_t b, size_t level, Op &op,
+                           bool idempotent) {
+    if (idempotent && a == b)
+        return a;
+
+    // The pool may grow below, so the children are copied
+    VarRangePool::Node na = pool->getNode(a), nb = pool->getNode(b);
+    for (size_t i = 0; i < VarRangePool::FANOUT; i++) {
+        if (idempotent && na[i] == nb[i])
+            continue;
+        if (level > 0) {
+            na[i] = combine(na[i], nb[i], level - 1, op, idempotent);
+            continue;
+        }
+        ValueSet v = pool->getValue(na[i]);
+        if (op(v, pool->getValue(nb[i])))
+            na[i] = pool->value(v);
+    }
+    return pool->node(na);
+}
+
+template <typename Op>
+bool VarRange::combine(const VarRange& _varRange, Op op, bool idempotent) {
+    if (!_varRange.pool) {
+        return false;
+    }
+    if (!pool) {
+        *this = _varRange;
+        return true;
+    }
+    uint32_t old = root;
+    root = combine(root, _varRange.root, pool->levels() - 1, op, idempotent);
+    return root != old;
+}
+
+} // namespace fdlang::analysis
+#endif
@@ -0,0 +1,190 @@
+#include "variableOrder.h"
+
+#include <algorithm>
+#include <cstdint>
+
+using namespace fdlang;
+using namespace fdlang::analysis;
+
+namespace {
+
+// Breadth-first search from `root', `level' holds the depth of the reached
+// vertices and is reset for them afterwards. Return the last level.
+std::vector<size_t> lastLevel(const std::vector<std::vector<size_t>> &adj,
+                              size_t root, std::vector<size_t> &level,
+                              size_t &depth) {
+    std::vector<size_t> reached = {root}, last;
+    level[root] = 0;
+    for (size_t head = 0; head < reached.size(); head++) {
+        size_t u = reached[head];
+        for (size_t v : adj[u]) {
+            if (level[v] != SIZE_MAX)
+                continue;
+            level[v] = level[u] + 1;
+            reached.push_back(v);
+        }
+    }
+
+    depth = level[reached.back()];
+    for (size_t u : reached) {
+        if (level[u] == depth)
+            last.push_back(u);
+        level[u] = SIZE_MAX;
+    }
+    return last;
+}
+
+// Vertex of the component of `root' far from the others, found by the
+// heuristic of George and Liu: restart from a vertex of smallest degree in
+// the last level while the depth grows
+size_t peripheral(const std::vector<std::vector<size_t>> &adj, size_t root,
+                  std::vector<size_t> &level) {
+    auto byDegree = [&](size_t a, size_t b) {
+        return std::make_pair(adj[a].size(), a) <
+               std::make_pair(adj[b].size(), b);
+    };
+
+    size_t depth;
+    std::vector<size_t> last = lastLevel(adj, root, level, depth);
+    while (true) {
+        size_t next = *std::min_element(last.begin(), last.end(), byDegree);
+        size_t nextDepth;
+        std::vector<size_t> nextLast = lastLevel(adj, next, level, nextDepth);
+        if (nextDepth <= depth)
+            return root;
+        root = next, depth = nextDepth, last = std::move(nextLast);
+    }
+}
+
+// Co-occurrence graph of the variables of `insts', numbered by their first
+// appearance in `vars'
+std::vector<std::vector<size_t>> cooccurrence(const IR::Insts &insts,
+                                              std::vector<Symbol> &vars) {
+    std::vector<size_t> ids(SymbolTable::get().size(), SIZE_MAX);
+    std::vector<std::vector<size_t>> adj;
+    std::vector<size_t> used;
+    for (auto inst : insts) {
+        used.clear();
+        for (size_t i = 0; i < inst->getOperandSize(); i++) {
+            if (!inst->getOperand(i)->isVariable())
+                continue;
+            Symbol var = inst->getOperand(i)->getAsVariable();
+            if (ids[var] == SIZE_MAX) {
+                ids[var] = vars.size();
+                vars.push_back(var);
+                adj.emplace_back();
+            }
+            used.push_back(ids[var]);
+        }
+        for (size_t a : used)
+            for (size_t b : used)
+                if (a != b)
+                    adj[a].push_back(b);
+    }
+    for (auto &neighbours : adj) {
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()),
+                         neighbours.end());
+    }
+    return adj;
+}
+
+} // namespace
+
+std::vector<size_t>
+fdlang::analysis::reverseCuthillMcKee(
+    const std::vector<std::vector<size_t>> &adj) {
+    size_t n = adj.size();
+    auto byDegree = [&](size_t a, size_t b) {
+        return std::make_pair(adj[a].size(), a) <
+               std::make_pair(adj[b].size(), b);
+    };
+
+    // Vertices by increasing degree, each component starts from the first
+    // one it has
+    std::vector<size_t> vertices(n);
+    for (size_t v = 0; v < n; v++)
+        vertices[v] = v;
+    std::stable_sort(vertices.begin(), vertices.end(), byDegree);
+
+    std::vector<size_t> order, level(n, SIZE_MAX), neighbours;
+    std::vector<bool> visited(n, false);
+    order.reserve(n);
+    for (size_t root : vertices) {
+        if (visited[root])
+            continue;
+        root = peripheral(adj, root, level);
+
+        visited[root] = true;
+        order.push_back(root);
+        for (size_t head = order.size() - 1; head < order.size(); head++) {
+            neighbours.clear();
+            for (size_t v : adj[order[head]])
+                if (!visited[v])
+                    neighbours.push_back(v);
+            std::sort(neighbours.begin(), neighbours.end(), byDegree);
+            for (size_t v : neighbours) {
+                visited[v] = true;
+                order.push_back(v);
+            }
+        }
+    }
+
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+std::vector<Symbol>
+fdlang::analysis::collectVariables(const IR::Insts &insts) {
+    std::vector<Symbol> vars;
+    std::vector<bool> seen(SymbolTable::get().size(), false);
+    for (auto inst : insts) {
+        for (size_t i = 0; i < inst->getOperandSize(); i++) {
+            if (!inst->getOperand(i)->isVariable())
+                continue;
+            Symbol var = inst->getOperand(i)->getAsVariable();
+            if (!seen[var]) {
+                seen[var] = true;
+                vars.push_back(var);
+            }
+        }
+    }
+    return vars;
+}
+
+std::vector<Symbol> fdlang::analysis::orderVariables(
+    const IR::Insts &insts) {
+    std::vector<Symbol> vars;
+    std::vector<std::vector<size_t>> adj = cooccurrence(insts, vars);
+
+    std::vector<Symbol> ordered;
+    ordered.reserve(vars.size());
+    for (size_t v : reverseCuthillMcKee(adj))
+        ordered.push_back(vars[v]);
+    return ordered;
+}
+
+size_t fdlang::analysis::largestComponent(const IR::Insts &insts) {
+    std::vector<Symbol> vars;
+    std::vector<std::vector<size_t>> adj = cooccurrence(insts, vars);
+
+    size_t largest = 0;
+    std::vector<bool> visited(adj.size(), false);
+    std::vector<size_t> reached;
+    for (size_t root = 0; root < adj.size(); root++) {
+        if (visited[root])
+            continue;
+        visited[root] = true;
+        reached.assign(1, root);
+        for (size_t head = 0; head < reached.size(); head++) {
+            for (size_t v : adj[reached[head]]) {
+                if (visited[v])
+                    continue;
+                visited[v] = true;
+                reached.push_back(v);
+            }
+        }
+        largest = std::max(largest, reached.size());
+    }
+    return largest;
+}
@@ -0,0 +1,50 @@
+#ifndef ANALYSIS_VARIABLEORDER_H
+#define ANALYSIS_VARIABLEORDER_H
+
+#include "IR/IR.h"
+
+#include <vector>
+
+namespace fdlang::analysis {
+
+/**
+ * @brief Get the reverse Cuthill-McKee order of the undirected graph `adj'
+ *
+ * Every connected component is laid out from a pseudo-peripheral vertex by a
+ * breadth-first search which visits the neighbours by increasing degree, and
+ * the whole order is reversed. Neighbours then get close positions, which
+ * keeps the bandwidth of the adjacency matrix small. Ties are broken by the
+ * vertex number, so the order is deterministic.
+ */
+std::vector<size_t>
+reverseCuthillMcKee(const std::vector<std::vector<size_t>> &adj);
+
+/**
+ * @brief Get the symbols of the variables of `insts', by their first
+ * appearance
+ */
+std::vector<Symbol> collectVariables(const IR::Insts &insts);
+
+/**
+ * @brief Get the symbols of the variables of `insts' in the order of their
+ * ids in a zone
+ *
+ * Variables of the same instruction, guards included, are neighbours in the
+ * co-occurrence graph, which is then ordered by `reverseCuthillMcKee'.
+ *
+ * No domain depends on this order, since `ZoneDomain' gathers every
+ * component into a matrix of its own whatever its ids.
+ */
+std::vector<Symbol> orderVariables(const IR::Insts &insts);
+
+/**
+ * @brief Get the number of variables of the largest connected component of
+ * the co-occurrence graph of `insts'
+ *
+ * No component of a zone over `insts' can grow larger.
+ */
+size_t largestComponent(const IR::Insts &insts);
+
+} // namespace fdlang::analysis
+
+#endif
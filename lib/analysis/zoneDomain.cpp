@@ -6,35 +6,218 @@
 
 using namespace fdlang::analysis;
 
-const long long ZoneDomain::INF = 0x3f3f3f3f;
+const long long ZoneDomain::INF = DBM::INF;
+ZoneDomain::Stats ZoneDomain::stats;
 
 /**
  * @brief Construct a new Zone Domain
  *
- * @param vars names of appeared variables
+ * @param env appeared variables
  * @param isInitialization true for initialization(all zero) and false for
  * bottom
  */
-ZoneDomain::ZoneDomain(const std::vector<std::string> &vars,
-                       bool isInitialization) {
-    _id_to_var.push_back("");
-    _var_to_id[""] = 0;
-    for (size_t i = 0; i < vars.size(); i++) {
-        size_t id = i + 1;
-        _id_to_var.push_back(vars[i]);
-        _var_to_id[vars[i]] = id;
+ZoneDomain::ZoneDomain(std::shared_ptr<const VarEnv> env,
+                       bool isInitialization)
+    : _env(std::move(env)) {
+    n = _env->size();
+    // All variables are zero, so the normal form bounds every difference by
+    // zero, which the bounds alone already say. Bottom gets the storage as
+    // well, so that joins into it do not allocate.
+    _dbm = Matrix(n, 0);
+    _comp.resize(n);
+    for (size_t i = 0; i < n; i++)
+        _comp[i] = i;
+    _bottom = !isInitialization;
+}
+
+ScratchVector<size_t> ZoneDomain::component(size_t v) const {
+    ScratchVector<size_t> block(n);
+    block.push_back(0);
+    for (size_t u = 1; u < n; u++)
+        if (_comp[u] == _comp[v])
+            block.push_back(u);
+    return block;
+}
+
+void ZoneDomain::merge(size_t i, size_t j) {
+    if (i == 0 || j == 0 || _comp[i] == _comp[j])
+        return;
+    size_t from = _comp[j], to = _comp[i];
+    for (size_t u = 1; u < n; u++)
+        if (_comp[u] == from)
+            _comp[u] = to;
+}
+
+void ZoneDomain::refreshCross(const ScratchVector<size_t> &block) const {
+    for (size_t b : block) {
+        if (b == 0)
+            continue;
+        for (size_t a = 1; a < n; a++) {
+            if (_comp[a] == _comp[b])
+                continue;
+            _dbm[a][b] = DBM::add(_dbm[a][0], _dbm[0][b]);
+            _dbm[b][a] = DBM::add(_dbm[b][0], _dbm[0][a]);
+        }
+    }
+}
+
+bool ZoneDomain::closeBlock(const ScratchVector<size_t> &block) const {
+    ScratchArena::Frame frame;
+    size_t m = block.size();
+    Matrix &sub = ScratchArena::current().matrix(m, INF);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < m; j++)
+            sub[i][j] = _dbm[block[i]][block[j]];
+    sub.close();
+    for (size_t i = 0; i < m; i++) {
+        if (sub[i][i] < 0) {
+            setBottom();
+            return false;
+        }
+    }
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < m; j++)
+            _dbm[block[i]][block[j]] = sub[i][j];
+    return true;
+}
+
+void ZoneDomain::setBottom() const {
+    _bottom = true;
+    _closed = true;
+    _pending.clear();
+}
+
+void ZoneDomain::close() const {
+    if (_bottom || (_closed && _pending.empty())) {
+        stats.avoidedClosures++;
+        return;
     }
-    n = _id_to_var.size();
+
+    ScratchArena::Frame frame;
+    ScratchVector<Constraint> pending(_pending.size());
+    for (const Constraint &constraint : _pending)
+        pending.push_back(constraint);
+    _pending.clear();
+
+    // k incremental closures cost k * n^2
+    if (_closed && pending.size() < n) {
+        for (auto [i, j, c] : pending) {
+            if (c >= _dbm[i][j])
+                continue;
+            _dbm[i][j] = c;
+            if (!closeEdge(i, j))
+                return;
+        }
+        return;
+    }
+
+    // Components without pending constraints are still closed
+    ScratchVector<size_t> labels(n + pending.size());
+    if (!_closed)
+        for (size_t label : _comp)
+            labels.push_back(label);
+    for (auto [i, j, c] : pending) {
+        _dbm[i][j] = std::min(_dbm[i][j], c);
+        labels.push_back(_comp[i == 0 ? j : i]);
+    }
+    std::sort(labels.begin(), labels.end());
+    labels.resize(std::unique(labels.begin(), labels.end()) - labels.begin());
+    labels.resize(std::remove(labels.begin(), labels.end(), 0) -
+                  labels.begin());
+
+    stats.fullClosures++;
+    _closed = true;
+    for (size_t label : labels) {
+        ScratchArena::Frame blockFrame;
+        ScratchVector<size_t> block = component(label);
+        if (!closeBlock(block))
+            return;
+        refreshCross(block);
+    }
+}
+
+void ZoneDomain::havoc(size_t k) {
+    // The sub-matrix without `k' is still normalized, so dropping the row and
+    // the column of `k' loses nothing
     for (size_t i = 0; i < n; i++)
-        _dbm.emplace_back(n, INF);
-    if (isInitialization) {
-        for (size_t i = 0; i < n; i++)
-            _dbm[i][i] = _dbm[0][i] = _dbm[i][0] = 0;
-    } else {
-        for (size_t i = 0; i < n; i++)
-            for (size_t j = 0; j < n; j++)
-                _dbm[i][j] = -INF;
+        _dbm[i][k] = _dbm[k][i] = INF;
+    _dbm[k][k] = 0;
+    _dbm[k][0] = 0;
+    _dbm[0][k] = 255;
+
+    // `k' leaves its component, which keeps a member as its label
+    size_t rest = 0;
+    for (size_t u = 1; u < n; u++) {
+        if (u == k || _comp[u] != _comp[k])
+            continue;
+        if (rest == 0)
+            rest = u;
+        _comp[u] = rest;
+    }
+    _comp[k] = k;
+}
+
+bool ZoneDomain::closeEdge(size_t i, size_t j) const {
+    stats.incrementalClosures++;
+    DBM::Value c = _dbm[i][j];
+    if (DBM::add(c, _dbm[j][i]) < 0) {
+        setBottom();
+        return false;
+    }
+
+    // Row `i' and column `j' are fixed points of the update since
+    // `c + _dbm[j][i] >= 0', so it can be done in place. Rows of the other
+    // components only see the new bounds.
+    ScratchArena::Frame frame;
+    ScratchVector<size_t> block = component(i == 0 ? j : i);
+    for (size_t a : block) {
+        DBM::Value ai = _dbm[a][i];
+        if (ai < INF)
+            _dbm.relaxRow(a, j, DBM::add(ai, c));
     }
+    refreshCross(block);
+
+    return true;
+}
+
+bool ZoneDomain::closeVar(size_t v) const {
+    stats.incrementalClosures++;
+
+    // Shortest paths from and to `v' leave the closed sub-matrix at most once,
+    // and never for another component since they would pass `0' twice
+    ScratchArena::Frame frame;
+    ScratchVector<size_t> block = component(v);
+    for (size_t k : block) {
+        if (k == v)
+            continue;
+        DBM::Value vk = _dbm[v][k], kv = _dbm[k][v];
+        for (size_t j : block) {
+            if (j == v)
+                continue;
+            _dbm[v][j] = std::min(_dbm[v][j], DBM::add(vk, _dbm[k][j]));
+            _dbm[j][v] = std::min(_dbm[j][v], DBM::add(_dbm[j][k], kv));
+        }
+    }
+
+    for (size_t k : block) {
+        if (k != v && DBM::add(_dbm[v][k], _dbm[k][v]) < 0) {
+            setBottom();
+            return false;
+        }
+    }
+    ScratchVector<size_t> var(1);
+    var.push_back(v);
+    refreshCross(var);
+
+    // Row and column `v' are fixed points since `_dbm[v][v] = 0'
+    for (size_t i : block) {
+        DBM::Value iv = _dbm[i][v];
+        if (i != v && iv < INF)
+            _dbm.relaxRow(i, v, iv);
+    }
+    refreshCross(block);
+
+    return true;
 }
 
 void ZoneDomain::dump(std::ostream &out) const {
@@ -74,10 +257,7 @@ ZoneDomain ZoneDomain::normalize() const {
     ZoneDomain ret = *this;
 
     // todo: Floyd (about 4 lines)
-    for (int k = 0; k < n; k++)
-        for (int i = 0; i < n; i++)
-            for (int j = 0; j < n; j++)
-                ret._dbm[i][j] = std::min(ret._dbm[i][j], ret._dbm[i][k] + ret._dbm[k][j]);
+    ret.close();
 
     return ret;
 }
@@ -86,25 +266,41 @@ ZoneDomain ZoneDomain::normalize() const {
  * @brief Test if `*this' is bottom
  */
 bool ZoneDomain::isEmpty() const {
-
-    // todo: Determine if there are negative loops (about 4 lines)
-    ZoneDomain res = this->normalize();
-    for (int i = 0; i < n; i++)
-        if (res._dbm[i][i] < 0)
-            return true;
-
-    return false;
+    // A negative cycle is only known after the closure
+    close();
+    return _bottom;
 }
 
 /**
  * @brief Test if `*this' is less or equal than `o' in partial order <=
  */
 bool ZoneDomain::leq(const ZoneDomain &o) const {
-    // Assume `*this' is already normalized
-    for (size_t i = 0; i < n; i++)
-        for (size_t j = 0; j < n; j++)
-            if (this->_dbm[i][j] > o._dbm[i][j])
-                return false;
+    if (this->isEmpty())
+        return true;
+    if (o.isEmpty())
+        return false;
+
+    // Entries of `o' between its components are implied by its bounds, and
+    // so are looser than the ones of `*this' once the bounds are
+    for (size_t v = 1; v < n; v++)
+        if (_dbm[0][v] > o._dbm[0][v] || _dbm[v][0] > o._dbm[v][0])
+            return false;
+
+    // Variables of each component of `o' are chained from its label, `0'
+    // ends the chains
+    ScratchArena::Frame frame;
+    ScratchArena &arena = ScratchArena::current();
+    size_t *head = arena.allocate<size_t>(n), *next = arena.allocate<size_t>(n);
+    std::fill(head, head + n, 0);
+    for (size_t v = n - 1; v >= 1; v--) {
+        next[v] = head[o._comp[v]];
+        head[o._comp[v]] = v;
+    }
+    for (size_t label = 1; label < n; label++)
+        for (size_t i = head[label]; i != 0; i = next[i])
+            for (size_t j = head[label]; j != 0; j = next[j])
+                if (_dbm[i][j] > o._dbm[i][j])
+                    return false;
     return true;
 }
 
@@ -112,20 +308,22 @@ bool ZoneDomain::leq(const ZoneDomain &o) const {
  * @brief Test if `*this' is equal to `o'
  */
 bool ZoneDomain::eq(const ZoneDomain &o) const {
-    // Assume `*this' is already normalized
-    for (size_t i = 0; i < n; i++)
-        for (size_t j = 0; j < n; j++)
-            if (this->_dbm[i][j] != o._dbm[i][j])
-                return false;
-    return true;
+    if (this->isEmpty() || o.isEmpty())
+        return this->_bottom == o._bottom;
+    return this->_dbm.eq(o._dbm);
 }
 
 /**
  * @brief Get the projection of `*this' on the variable `x'
  */
 IntervalDomain ZoneDomain::projection(const std::string &x) const {
-    size_t id = getID(x);
-    return IntervalDomain(-_dbm[id][0], _dbm[0][id]);
+    return projection(getID(x));
+}
+
+IntervalDomain ZoneDomain::projection(size_t x) const {
+    if (isEmpty())
+        return IntervalDomain(INF, -INF);
+    return IntervalDomain(-_dbm[x][0], _dbm[0][x]);
 }
 
 /**
@@ -133,101 +331,118 @@ IntervalDomain ZoneDomain::projection(const std::string &x) const {
  */
 ZoneDomain ZoneDomain::lub(const ZoneDomain &o) const {
     ZoneDomain ret = *this;
-
-    for (size_t i = 0; i < n; i++)
-        for (size_t j = 0; j < n; j++)
-            ret._dbm[i][j] = std::max(this->_dbm[i][j], o._dbm[i][j]);
-
-    ret = ret.normalize();
+    ret.joinWith(o);
     return ret;
 }
 
-/**
- * @brief Get the new zone which forgets the variable `x'
- */
-ZoneDomain ZoneDomain::forget(const std::string &x) const {
-    ZoneDomain ret = *this;
-    size_t k = getID(x);
+void ZoneDomain::joinWith(const ZoneDomain &o) {
+    if (this->isEmpty()) {
+        *this = o;
+        return;
+    }
+    if (o.isEmpty())
+        return;
 
-    for (size_t i = 0; i < n; i++)
-        for (size_t j = 0; j < n; j++) {
-            if (i != k && j != k)
-                ret._dbm[i][j] = std::min(this->_dbm[i][j],
-                                          this->_dbm[i][k] + this->_dbm[k][j]);
-            else if (i == j && j == k)
-                ret._dbm[i][j] = 0;
-            else
-                ret._dbm[i][j] = INF;
-        }
-    ret._dbm[k][0] = 0;
-    ret._dbm[0][k] = 255;
+    // A pair between the components of both sides only gets related when the
+    // lower bound of `a' and the upper bound of `b' come from different sides
+    ScratchArena::Frame frame;
+    ScratchVector<size_t> lowerA(n), lowerB(n), upperA(n), upperB(n);
+    for (size_t v = 1; v < n; v++) {
+        if (_dbm[v][0] != o._dbm[v][0])
+            (_dbm[v][0] > o._dbm[v][0] ? lowerA : lowerB).push_back(v);
+        if (_dbm[0][v] != o._dbm[0][v])
+            (_dbm[0][v] > o._dbm[0][v] ? upperA : upperB).push_back(v);
+    }
 
-    ret = ret.normalize();
-    return ret;
+    // Both sides are normalized by `isEmpty', and so is their maximum
+    _dbm.maxWith(o._dbm);
+    stats.avoidedClosures++;
+
+    // The components of the result merge the ones of both sides
+    size_t *parent = ScratchArena::current().allocate<size_t>(n);
+    for (size_t v = 0; v < n; v++)
+        parent[v] = v;
+    auto find = [&](size_t v) {
+        while (parent[v] != v)
+            v = parent[v] = parent[parent[v]];
+        return v;
+    };
+    auto unite = [&](size_t a, size_t b) { parent[find(a)] = find(b); };
+    for (size_t v = 1; v < n; v++) {
+        unite(v, _comp[v]);
+        unite(v, o._comp[v]);
+    }
+    auto relate = [&](const ScratchVector<size_t> &as,
+                      const ScratchVector<size_t> &bs) {
+        for (size_t a : as)
+            for (size_t b : bs)
+                if (find(a) != find(b) &&
+                    _dbm[a][b] < DBM::add(_dbm[a][0], _dbm[0][b]))
+                    unite(a, b);
+    };
+    relate(lowerA, upperB);
+    relate(lowerB, upperA);
+    for (size_t v = 1; v < n; v++)
+        _comp[v] = find(v);
 }
 
 /**
- * @brief Get the new zone filtered by `inst'
+ * @brief Get the new zone which widens `*this' with `o'
+ *
+ * Unstable bounds jump to the next of the sorted `thresholds', unstable
+ * relations between variables are dropped.
  */
-ZoneDomain ZoneDomain::filterInst(const IR::IfInst *inst, bool branch) const {
-
-    std::string x = inst->getOperand(0)->getAsVariable();
-    long long c = inst->getOperand(1)->getAsNumber();
-    IR::CmpOperator op = inst->getCmpOperator();
+ZoneDomain ZoneDomain::widen(const ZoneDomain &o,
+                             const std::vector<long long> &thresholds) const {
     ZoneDomain ret = *this;
+    ret.widenWith(o, thresholds);
+    return ret;
+}
 
-    if (!branch) {
-        // In fact, the condition that `x != v' can also reduce the state
-        // space, but it is only effective when the boundary is equal to v. For
-        // simplicity, we do not filter it, which has almost no impact on
-        // precision
-        if (op == IR::CmpOperator::EQ)
-            return ret;
-
-        // In other cases, we invert the conditions and filter them
-        switch (op) {
-        case IR::CmpOperator::GT:
-            op = IR::CmpOperator::LEQ;
-            break;
-        case IR::CmpOperator::GEQ:
-            op = IR::CmpOperator::LT;
-            break;
-        case IR::CmpOperator::LT:
-            op = IR::CmpOperator::GEQ;
-            break;
-        case IR::CmpOperator::LEQ:
-            op = IR::CmpOperator::GT;
-            break;
-        default:
-            assert(false);
-        }
+void ZoneDomain::widenWith(const ZoneDomain &o,
+                           const std::vector<long long> &thresholds) {
+    if (this->isEmpty()) {
+        *this = o;
+        return;
     }
 
-    switch (op) {
-    case IR::CmpOperator::EQ:
-        ret = this->filter(x, "", c).filter("", x, -c);
-        break;
-    case IR::CmpOperator::GEQ:
-        ret = this->filter("", x, -c);
-        break;
-    case IR::CmpOperator::GT:
-        ret = this->filter("", x, -(c + 1));
-        break;
-    case IR::CmpOperator::LEQ:
-        ret = this->filter(x, "", c);
-        break;
-    case IR::CmpOperator::LT:
-        ret = this->filter(x, "", c - 1);
-        break;
-    default:
-        assert(false);
+    // Entries which the join loosens are the unstable ones
+    ScratchArena::Frame frame;
+    const Matrix &before = ScratchArena::current().matrix(_dbm);
+    joinWith(o);
+
+    for (size_t v = 1; v < n; v++) {
+        if (_dbm[0][v] > before[0][v])
+            _dbm[0][v] = DBM::bound(widenUpper(thresholds, _dbm[0][v]));
+        if (_dbm[v][0] > before[v][0])
+            _dbm[v][0] = DBM::bound(-widenLower(thresholds, -_dbm[v][0]));
     }
+    for (size_t i = 1; i < n; i++)
+        for (size_t j = 1; j < n; j++)
+            if (_dbm[i][j] > before[i][j])
+                _dbm[i][j] = INF;
 
-    ret = ret.normalize();
+    // The bounds only grow, so the closure finds no negative cycle
+    _closed = false;
+}
 
+/**
+ * @brief Get the new zone which forgets the variable `x'
+ */
+ZoneDomain ZoneDomain::forget(const std::string &x) const {
+    ZoneDomain ret = *this;
+    ret.forget(getID(x));
     return ret;
 }
 
+void ZoneDomain::forget(size_t x) {
+    if (this->isEmpty())
+        return;
+
+    havoc(x);
+    closeVar(x);
+}
+
 /**
  * @brief Get the new zone filtered by guard `x - y <= c'
  *
@@ -237,149 +452,24 @@ ZoneDomain ZoneDomain::filterInst(const IR::IfInst *inst, bool branch) const {
 ZoneDomain ZoneDomain::filter(const std::string &x, const std::string &y,
                               long long c) const {
     ZoneDomain ret = *this;
-
-    // todo: add constraint `x - y <= c' (about 3 lines)
-    size_t j = getID(x);
-    size_t i = getID(y);
-    ret._dbm[i][j] = std::min(this->_dbm[i][j], c);
-
+    ret.filter(getID(x), getID(y), c);
     return ret;
 }
 
-/**
- * @brief Get the new zone after excuting assigment/add/sub `inst'
- */
-ZoneDomain ZoneDomain::assignInst(const IR::Inst *inst) const {
-    std::string x;
-    ZoneDomain ret;
-
-    if (const IR::AddInst *addInst = dynamic_cast<const IR::AddInst *>(inst)) {
-        x = addInst->getOperand(0)->getAsVariable();
-        IR::Value *operand1 = addInst->getOperand(1);
-        IR::Value *operand2 = addInst->getOperand(2);
-
-        // case: x <- c1 + c2
-        if (operand1->isNumber() && operand2->isNumber())
-            ret = this->assign_case2(
-                x, "", operand1->getAsNumber() + operand2->getAsNumber());
-        // case: x <- y + c || x <- c + y
-        else if (operand1->isNumber() || operand2->isNumber()) {
-            if (operand1->isNumber())
-                std::swap(operand1, operand2);
-            std::string y = operand1->getAsVariable();
-            long long c = operand2->getAsNumber();
-            // subcase: x == y
-            if (x == y)
-                ret = this->assign_case1(x, c);
-            // subcase: x != y
-            else
-                ret = this->assign_case2(x, y, c);
-        }
-        // case: x <- y + z
-        else {
-            IntervalDomain interval1 =
-                this->projection(operand1->getAsVariable());
-            IntervalDomain interval2 =
-                this->projection(operand2->getAsVariable());
-            long long l = interval1.l + interval2.l;
-            long long r = interval1.r + interval2.r;
-            ret = this->assign_case3(x, l, r);
-        }
-    }
-    if (const IR::SubInst *subInst = dynamic_cast<const IR::SubInst *>(inst)) {
-        x = subInst->getOperand(0)->getAsVariable();
-        IR::Value *operand1 = subInst->getOperand(1);
-        IR::Value *operand2 = subInst->getOperand(2);
-
-        // case: x <- c1 - c2
-        if (operand1->isNumber() && operand2->isNumber())
-            ret = this->assign_case2(
-                x, "", operand1->getAsNumber() - operand2->getAsNumber());
-        // case: x <- y - c
-        else if (operand2->isNumber()) {
-            std::string y = operand1->getAsVariable();
-            long long c = operand2->getAsNumber();
-            // subcase: x == y
-            if (x == y)
-                ret = this->assign_case1(x, -c);
-            // subcase: x != y
-            else
-                ret = this->assign_case2(x, y, -c);
-        }
-        // case: x <- c - y
-        else if (operand1->isNumber()) {
-            long long c = operand1->getAsNumber();
-            IntervalDomain interval =
-                this->projection(operand2->getAsVariable());
-            long long l = c - interval.r;
-            long long r = c - interval.l;
-            ret = this->assign_case3(x, l, r);
-        }
-        // case: x <- y - z
-        else {
-            IntervalDomain interval1 =
-                this->projection(operand1->getAsVariable());
-            IntervalDomain interval2 =
-                this->projection(operand2->getAsVariable());
-            long long l = interval1.l - interval2.r;
-            long long r = interval1.r - interval2.l;
-            ret = this->assign_case3(x, l, r);
-        }
-    }
-    if (const IR::AssignInst *assignInst =
-            dynamic_cast<const IR::AssignInst *>(inst)) {
-        x = assignInst->getOperand(0)->getAsVariable();
-        IR::Value *operand = assignInst->getOperand(1);
-
-        // case: x <- c
-        if (operand->isNumber())
-            ret = this->assign_case2(x, "", operand->getAsNumber());
-        // case: x <- y
-        else if (operand->isVariable()) {
-            std::string y = operand->getAsVariable();
-            // subcase: x == y
-            if (x == y)
-                ret = *this;
-            // subcase: x != y
-            else
-                ret = this->assign_case2(x, y, 0);
-        }
-    }
-    if (const IR::InputInst *inputInst =
-            dynamic_cast<const IR::InputInst *>(inst)) {
-        // x <- [0, 255]
-        x = inputInst->getOperand(0)->getAsVariable();
-        ret = this->assign_case3(x, 0, 255);
+void ZoneDomain::filter(size_t x, size_t y, long long c) {
+    // todo: add constraint `x - y <= c' (about 3 lines)
+    if (!_bottom) {
+        _pending.push_back({y, x, DBM::bound(c)});
+        merge(y, x);
     }
-
-    ret = ret.normalize();
-    return ret;
 }
 
 /**
  * @brief Get the new zone after excuting `x = x + c'
  */
 ZoneDomain ZoneDomain::assign_case1(const std::string &x, long long c) const {
-    size_t i0 = getID(x);
     ZoneDomain ret = *this;
-
-    long long pc = c;
-    pc = std::min(pc, 255ll - ret._dbm[0][i0]);
-    pc = std::max(pc, -ret._dbm[0][i0]);
-    long long mc = c;
-    mc = std::min(mc, 255ll + ret._dbm[i0][0]);
-    mc = std::max(mc, ret._dbm[i0][0]);
-
-    for (size_t i = 0; i < n; i++)
-        for (size_t j = 0; j < n; j++) {
-            if (i == i0 && j != i0) {
-                ret._dbm[i][j] -= mc;
-            }
-            if (i != i0 && j == i0) {
-                ret._dbm[i][j] += pc;
-            }
-        }
-
+    ret.assign(getID(x), getID(x), c);
     return ret;
 }
 
@@ -390,12 +480,53 @@ ZoneDomain ZoneDomain::assign_case1(const std::string &x, long long c) const {
  */
 ZoneDomain ZoneDomain::assign_case2(const std::string &x, const std::string &y,
                                     long long c) const {
-    ZoneDomain ret;
+    ZoneDomain ret = *this;
+    ret.assign(getID(x), getID(y), c);
+    return ret;
+}
 
-    // todo: (about 1 line)
-    ret = this->forget(x).filter(x, y, c).filter(y, x, -c);
+void ZoneDomain::assign(size_t x, size_t y, long long c) {
+    if (this->isEmpty())
+        return;
+    size_t i0 = x;
+
+    if (y == x) {
+        long long pc = c;
+        pc = std::min(pc, 255ll - _dbm[0][i0]);
+        pc = std::max(pc, -(long long)_dbm[0][i0]);
+        long long mc = c;
+        mc = std::min(mc, 255ll + _dbm[i0][0]);
+        mc = std::max(mc, (long long)_dbm[i0][0]);
+
+        // `x' moves by `mc' at its lower bound and by `pc' at its upper one
+        _dbm[i0][0] = DBM::add(_dbm[i0][0], DBM::bound(-mc));
+        _dbm[0][i0] = DBM::add(_dbm[0][i0], DBM::bound(pc));
+        for (size_t j = 1; j < n; j++) {
+            if (j == i0)
+                continue;
+            if (pc == mc) {
+                _dbm[i0][j] = DBM::add(_dbm[i0][j], DBM::bound(-pc));
+                _dbm[j][i0] = DBM::add(_dbm[j][i0], DBM::bound(pc));
+            } else {
+                shiftSaturated(_dbm[j][i0], _dbm[i0][j], c, -_dbm[j][0],
+                               _dbm[0][j]);
+            }
+        }
 
-    return ret;
+        // `pc' and `mc' differ when `x' saturates, then paths through `x'
+        // may become shorter
+        if (pc != mc)
+            closeVar(i0);
+        return;
+    }
+
+    // todo: (about 1 line)
+    size_t j0 = y;
+    havoc(i0);
+    merge(j0, i0);
+    _dbm[j0][i0] = std::min(_dbm[j0][i0], DBM::bound(c));
+    _dbm[i0][j0] = std::min(_dbm[i0][j0], DBM::bound(-c));
+    closeVar(i0);
 }
 
 /**
@@ -403,14 +534,21 @@ ZoneDomain ZoneDomain::assign_case2(const std::string &x, const std::string &y,
  */
 ZoneDomain ZoneDomain::assign_case3(const std::string &x, long long l,
                                     long long r) const {
+    ZoneDomain ret = *this;
+    ret.assignInterval(getID(x), l, r);
+    return ret;
+}
+
+void ZoneDomain::assignInterval(size_t x, long long l, long long r) {
     l = std::max(l, 0ll);
     r = std::min(r, 255ll);
 
     // todo: (about 4 lines)
-    ZoneDomain ret = this->forget(x);
-    size_t i0 = getID(x);
-    ret._dbm[i0][0] = -l;
-    ret._dbm[0][i0] = r;
-
-    return ret;
+    if (this->isEmpty())
+        return;
+    size_t i0 = x;
+    havoc(i0);
+    _dbm[i0][0] = DBM::bound(-l);
+    _dbm[0][i0] = DBM::bound(r);
+    closeVar(i0);
 }
@@ -2,60 +2,157 @@
 #define ANALYSIS_QUADRIALATERALDOMAIN_H
 
 #include "IR/IR.h"
+#include "dbm.h"
+#include "scratchArena.h"
+#include "zoneTransfer.h"
 
 #include <map>
+#include <memory>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 namespace fdlang::analysis {
 
-class IntervalDomain {
+class ZoneDomain : public ZoneTransfer<ZoneDomain> {
 public:
-    long long l, r;
-    IntervalDomain(long long l, long long r) : l(l), r(r) {}
-};
+    struct Stats {
+        // Floyd-Warshall runs
+        size_t fullClosures = 0;
+        // O(n^2) runs of `closeEdge' and `closeVar'
+        size_t incrementalClosures = 0;
+        // Closures skipped because the zone was already normalized
+        size_t avoidedClosures = 0;
+    };
 
-class ZoneDomain {
 private:
     static const long long INF;
-    size_t n;
+    static Stats stats;
+    size_t n = 0;
 
-    std::vector<std::string> _id_to_var;
-    std::unordered_map<std::string, size_t> _var_to_id;
+    std::shared_ptr<const VarEnv> _env;
 
-    using Matrix = std::vector<std::vector<long long>>;
+    using Matrix = DBM;
     /**
      * var_i - 0 <= _dbm[i][0]
      * 0 - var_i <= _dbm[0][i]
      * var_i - var_j <= _dbm[i][j]
+     *
+     * Meaningless for bottom, but kept for its storage
+     */
+    mutable Matrix _dbm;
+
+    struct Constraint {
+        size_t i, j;
+        DBM::Value c;
+    };
+
+    // Constraints `_dbm[i][j] <= c' added since the last closure, they are
+    // applied by `close' once a query needs the normal form
+    mutable std::vector<Constraint> _pending;
+
+    // `_dbm' is in normal form, not counting `_pending'
+    mutable bool _closed = true;
+
+    /**
+     * Partition of the variables into independent components, variables
+     * with the same label belong to the same component and the label is one
+     * of them. Between two components the normal form holds nothing but the
+     * bounds: `_dbm[i][j] = _dbm[i][0] + _dbm[0][j]', so only the blocks of
+     * the components have to be closed.
+     */
+    std::vector<size_t> _comp;
+
+    mutable bool _bottom = false;
+
+    const std::string &getVar(size_t id) const { return _env->getVar(id); }
+
+    size_t getID(const std::string &x) const { return _env->getID(x); }
+
+    /**
+     * @brief Turn `*this' into bottom
+     */
+    void setBottom() const;
+
+    /**
+     * @brief Get `0' and the variables in the component of `v', in the
+     * current scratch frame
+     */
+    ScratchVector<size_t> component(size_t v) const;
+
+    /**
+     * @brief Merge the components of `i' and `j'
+     */
+    void merge(size_t i, size_t j);
+
+    /**
+     * @brief Recompute the entries between the variables of `block' and the
+     * other components from the bounds
+     */
+    void refreshCross(const ScratchVector<size_t> &block) const;
+
+    /**
+     * @brief Floyd-Warshall closure of the sub-matrix on `block'
+     *
+     * Return false and turn `*this' into bottom on a negative cycle.
      */
-    Matrix _dbm;
+    bool closeBlock(const ScratchVector<size_t> &block) const;
 
-    std::string getVar(size_t id) const {
-        assert(0 <= id && id < _id_to_var.size());
-        return _id_to_var[id];
-    }
+    /**
+     * @brief Apply `_pending' and bring `_dbm' into normal form
+     *
+     * A few pending constraints on a normalized matrix are applied one by one
+     * with `closeEdge', otherwise a full Floyd-Warshall runs on every
+     * component they touch.
+     */
+    void close() const;
+
+    /**
+     * @brief Drop every constraint on `k' except `0 <= k <= 255'
+     *
+     * The result is not normalized, see `closeVar'
+     */
+    void havoc(size_t k);
+
+    /**
+     * @brief Restore the normal form after tightening `_dbm[i][j]'
+     *
+     * Assume `*this' was normalized before `_dbm[i][j]' was tightened, so
+     * only paths going through the new edge have to be considered, which
+     * takes O(n * s) instead of O(n^3) for a component of size s. Return
+     * false and turn `*this' into bottom if the new edge closes a negative
+     * cycle.
+     */
+    bool closeEdge(size_t i, size_t j) const;
 
-    size_t getID(const std::string &x) const {
-        auto it = _var_to_id.find(x);
-        assert(it != _var_to_id.end());
-        return it->second;
-    }
+    /**
+     * @brief Restore the normal form after rewriting the row and column of `v'
+     *
+     * Assume the sub-matrix without `v' is normalized. Return false and turn
+     * `*this' into bottom if a negative cycle goes through `v'.
+     */
+    bool closeVar(size_t v) const;
 
 public:
     /**
      * @brief Construct a new Zone Domain
      *
-     * @param vars names of appeared variables
+     * @param vars symbols of appeared variables
      * @param isInitialization true for initialization(all zero) and false for
      * bottom
      */
-    ZoneDomain(const std::vector<std::string> &vars, bool isInitialization);
+    ZoneDomain(const std::vector<Symbol> &vars, bool isInitialization)
+        : ZoneDomain(std::make_shared<const VarEnv>(vars), isInitialization) {}
+    ZoneDomain(std::shared_ptr<const VarEnv> env, bool isInitialization);
     ZoneDomain() = default;
 
+    const VarEnv &env() const { return *_env; }
+
     void dump(std::ostream &out) const;
 
+    static const Stats &getStats() { return stats; }
+
+    static void resetStats() { stats = Stats(); }
+
     /**
      * @brief Get the new zone which is the normal form of `*this'
      */
@@ -87,14 +184,18 @@ public:
     ZoneDomain lub(const ZoneDomain &o) const;
 
     /**
-     * @brief Get the new zone which forgets the variable `x'
+     * @brief Get the new zone which widens `*this' with `o'
+     *
+     * Unstable bounds jump to the next of the sorted `thresholds', unstable
+     * relations between variables are dropped.
      */
-    ZoneDomain forget(const std::string &x) const;
+    ZoneDomain widen(const ZoneDomain &o,
+                     const std::vector<long long> &thresholds) const;
 
     /**
-     * @brief Get the new zone filtered by `inst'
+     * @brief Get the new zone which forgets the variable `x'
      */
-    ZoneDomain filterInst(const IR::IfInst *inst, bool branch) const;
+    ZoneDomain forget(const std::string &x) const;
 
     /**
      * @brief Get the new zone filtered by guard `x - y <= c'
@@ -105,11 +206,6 @@ public:
     ZoneDomain filter(const std::string &x, const std::string &y,
                       long long c) const;
 
-    /**
-     * @brief Get the new zone after excuting assigment/add/sub `inst'
-     */
-    ZoneDomain assignInst(const IR::Inst *inst) const;
-
     /**
      * @brief Get the new zone after excuting `x = x + c'
      */
@@ -128,6 +224,47 @@ public:
      */
     ZoneDomain assign_case3(const std::string &x, long long l,
                             long long r) const;
+
+    // In-place operations on the variable ids of `env()', where 0 is the
+    // constant zero
+
+    /**
+     * @brief Get the projection of `*this' on the variable `x'
+     */
+    IntervalDomain projection(size_t x) const;
+
+    /**
+     * @brief Join `o' into `*this'
+     */
+    void joinWith(const ZoneDomain &o);
+
+    /**
+     * @brief Widen `*this' with `o', see `widen'
+     */
+    void widenWith(const ZoneDomain &o,
+                   const std::vector<long long> &thresholds);
+
+    /**
+     * @brief Forget the variable `x'
+     */
+    void forget(size_t x);
+
+    /**
+     * @brief Filter by guard `x - y <= c'
+     */
+    void filter(size_t x, size_t y, long long c);
+
+    /**
+     * @brief Excute `x = y + c'
+     *
+     * It is `x = x + c' for y == x and `x = c' for y == 0.
+     */
+    void assign(size_t x, size_t y, long long c);
+
+    /**
+     * @brief Excute `x = [l, r]'
+     */
+    void assignInterval(size_t x, long long l, long long r);
 };
 
 } // namespace fdlang::analysis
@@ -0,0 +1,341 @@
+#ifndef ANALYSIS_ZONETRANSFER_H
+#define ANALYSIS_ZONETRANSFER_H
+
+#include "IR/IR.h"
+#include "dbm.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace fdlang::analysis {
+
+class IntervalDomain {
+public:
+    long long l, r;
+    IntervalDomain(long long l, long long r) : l(l), r(r) {}
+};
+
+/**
+ * Variables of a program, shared and never modified by all zones of an
+ * analysis. Id 0 is the constant zero, named "". Ids are found by indexing
+ * with the `Symbol' of the variable, nothing is hashed.
+ */
+class VarEnv {
+private:
+    static constexpr size_t NONE = SIZE_MAX;
+
+    std::vector<Symbol> _id_to_symbol;
+    std::vector<size_t> _symbol_to_id;
+
+public:
+    VarEnv(const std::vector<Symbol> &vars) {
+        _id_to_symbol.push_back(0);
+        for (size_t i = 0; i < vars.size(); i++) {
+            size_t id = i + 1;
+            if (vars[i] >= _symbol_to_id.size())
+                _symbol_to_id.resize(vars[i] + 1, NONE);
+            _id_to_symbol.push_back(vars[i]);
+            _symbol_to_id[vars[i]] = id;
+        }
+    }
+
+    size_t size() const { return _id_to_symbol.size(); }
+
+    const std::string &getVar(size_t id) const {
+        static const std::string zero;
+        assert(0 <= id && id < _id_to_symbol.size());
+        return id == 0 ? zero : SymbolTable::get().getName(_id_to_symbol[id]);
+    }
+
+    size_t getID(Symbol x) const {
+        assert(x < _symbol_to_id.size() && _symbol_to_id[x] != NONE);
+        return _symbol_to_id[x];
+    }
+
+    // By name, for the zones built by hand, "" is the constant zero
+    size_t getID(std::string_view x) const {
+        return x.empty() ? 0 : getID(SymbolTable::get().lookup(x));
+    }
+};
+
+/**
+ * Zone operation an IR instruction is lowered to, variables are resolved to
+ * their ids in a `VarEnv' once so that applying it needs no lookup
+ */
+struct ZoneOp {
+    enum class Kind {
+        Identity,
+        // l <= x <= r, LLONG_MIN and LLONG_MAX for no bound
+        Filter,
+        // x = y + c, y is 0 for a constant
+        Assign,
+        // x = [l, r] + sy * y + sz * z, evaluated on the projections
+        AssignInterval,
+    };
+
+    Kind kind = Kind::Identity;
+    size_t x = 0, y = 0, z = 0;
+    long long c = 0, l = 0, r = 0;
+    int sy = 0, sz = 0;
+
+    /**
+     * @brief Lower `inst' on the edge to its `succ'-th successor
+     *
+     * The first successor of an `IfInst' is the false branch.
+     */
+    static ZoneOp lower(const IR::Inst *inst, size_t succ, const VarEnv &env);
+};
+
+inline ZoneOp ZoneOp::lower(const IR::Inst *inst, size_t succ,
+                            const VarEnv &env) {
+    ZoneOp op;
+
+    if (inst->getInstType() == IR::InstType::IfInst) {
+        const IR::IfInst *ifInst = (const IR::IfInst *)inst;
+        IR::CmpOperator cmp = ifInst->getCmpOperator();
+        long long c = inst->getOperand(1)->getAsNumber();
+
+        if (succ == 0) {
+            // In fact, the condition that `x != v' can also reduce the state
+            // space, but it is only effective when the boundary is equal to
+            // v. For simplicity, we do not filter it, which has almost no
+            // impact on precision
+            if (cmp == IR::CmpOperator::EQ)
+                return op;
+
+            // In other cases, we invert the conditions and filter them
+            switch (cmp) {
+            case IR::CmpOperator::GT:
+                cmp = IR::CmpOperator::LEQ;
+                break;
+            case IR::CmpOperator::GEQ:
+                cmp = IR::CmpOperator::LT;
+                break;
+            case IR::CmpOperator::LT:
+                cmp = IR::CmpOperator::GEQ;
+                break;
+            case IR::CmpOperator::LEQ:
+                cmp = IR::CmpOperator::GT;
+                break;
+            default:
+                assert(false);
+            }
+        }
+
+        op.kind = Kind::Filter;
+        op.x = env.getID(inst->getOperand(0)->getAsVariable());
+        op.l = LLONG_MIN, op.r = LLONG_MAX;
+        switch (cmp) {
+        case IR::CmpOperator::EQ:
+            op.l = op.r = c;
+            break;
+        case IR::CmpOperator::GEQ:
+            op.l = c;
+            break;
+        case IR::CmpOperator::GT:
+            op.l = c + 1;
+            break;
+        case IR::CmpOperator::LEQ:
+            op.r = c;
+            break;
+        case IR::CmpOperator::LT:
+            op.r = c - 1;
+            break;
+        default:
+            assert(false);
+        }
+        return op;
+    }
+
+    auto id = [&](IR::Value *v) { return env.getID(v->getAsVariable()); };
+
+    switch (inst->getInstType()) {
+    case IR::InstType::AddInst:
+    case IR::InstType::SubInst: {
+        bool add = inst->getInstType() == IR::InstType::AddInst;
+        op.x = id(inst->getOperand(0));
+        IR::Value *operand1 = inst->getOperand(1);
+        IR::Value *operand2 = inst->getOperand(2);
+        op.kind = Kind::Assign;
+
+        // case: x <- c1 + c2 || x <- c1 - c2
+        if (operand1->isNumber() && operand2->isNumber())
+            op.c = add ? operand1->getAsNumber() + operand2->getAsNumber()
+                       : operand1->getAsNumber() - operand2->getAsNumber();
+        // case: x <- y + c || x <- c + y || x <- y - c
+        else if (operand2->isNumber() || (add && operand1->isNumber())) {
+            if (operand1->isNumber())
+                std::swap(operand1, operand2);
+            op.y = id(operand1);
+            op.c = add ? operand2->getAsNumber() : -operand2->getAsNumber();
+        }
+        // case: x <- c - y
+        else if (operand1->isNumber()) {
+            op.kind = Kind::AssignInterval;
+            op.l = op.r = operand1->getAsNumber();
+            op.y = id(operand2), op.sy = -1;
+        }
+        // case: x <- y + z || x <- y - z
+        else {
+            op.kind = Kind::AssignInterval;
+            op.y = id(operand1), op.sy = 1;
+            op.z = id(operand2), op.sz = add ? 1 : -1;
+        }
+        break;
+    }
+    case IR::InstType::AssignInst: {
+        op.x = id(inst->getOperand(0));
+        IR::Value *operand = inst->getOperand(1);
+        op.kind = Kind::Assign;
+
+        // case: x <- c
+        if (operand->isNumber())
+            op.c = operand->getAsNumber();
+        // case: x <- y, nothing to do when x == y
+        else if ((op.y = id(operand)) == op.x)
+            op.kind = Kind::Identity;
+        break;
+    }
+    case IR::InstType::InputInst:
+        // x <- [0, 255]
+        op.kind = Kind::AssignInterval;
+        op.x = id(inst->getOperand(0));
+        op.l = 0, op.r = 255;
+        break;
+    default:
+        break;
+    }
+
+    return op;
+}
+
+/**
+ * Transfer functions of IR instructions, shared by every zone representation
+ *
+ * `Zone' derives from `ZoneTransfer<Zone>' and provides `env', `projection',
+ * and the in-place `filter', `assign' and `assignInterval' on variable ids,
+ * which the instructions are lowered to.
+ */
+template <typename Zone> class ZoneTransfer {
+private:
+    const Zone &self() const { return static_cast<const Zone &>(*this); }
+
+    Zone &self() { return static_cast<Zone &>(*this); }
+
+protected:
+    /**
+     * @brief Get the least of the sorted `thresholds' >= c
+     */
+    static long long widenUpper(const std::vector<long long> &thresholds,
+                                long long c) {
+        auto it = std::lower_bound(thresholds.begin(), thresholds.end(), c);
+        return it == thresholds.end() ? LLONG_MAX : *it;
+    }
+
+    /**
+     * @brief Get the greatest of the sorted `thresholds' <= c
+     */
+    static long long widenLower(const std::vector<long long> &thresholds,
+                                long long c) {
+        auto it = std::upper_bound(thresholds.begin(), thresholds.end(), c);
+        return it == thresholds.begin() ? LLONG_MIN : *--it;
+    }
+
+    /**
+     * @brief Update the bounds `in' of `x - y' and `out' of `y - x' for
+     * `x = x + c' when `x' may saturate, `y' being in [ly, uy]
+     *
+     * `x' either moves by `c' or stops at 0 or 255, so each bound is the
+     * loosest of the two cases.
+     */
+    static void shiftSaturated(DBM::Value &in, DBM::Value &out, long long c,
+                               long long ly, long long uy) {
+        in = DBM::add(in, DBM::bound(c));
+        out = DBM::add(out, DBM::bound(-c));
+        if (c < 0) {
+            in = std::max<long long>(in, -ly);
+            out = std::min<long long>(out, uy);
+        } else {
+            in = std::min<long long>(in, 255 - ly);
+            out = std::max<long long>(out, uy - 255);
+        }
+    }
+
+public:
+    /**
+     * @brief Apply `op' to `*this'
+     */
+    void apply(const ZoneOp &op);
+
+    /**
+     * @brief Get the new zone filtered by `inst'
+     */
+    Zone filterInst(const IR::IfInst *inst, bool branch) const {
+        Zone ret = self();
+        ret.apply(ZoneOp::lower(inst, branch, self().env()));
+        return ret;
+    }
+
+    /**
+     * @brief Get the new zone after excuting assigment/add/sub `inst'
+     */
+    Zone assignInst(const IR::Inst *inst) const {
+        Zone ret = self();
+        ret.apply(ZoneOp::lower(inst, 0, self().env()));
+        return ret;
+    }
+};
+
+template <typename Zone> void ZoneTransfer<Zone>::apply(const ZoneOp &op) {
+    switch (op.kind) {
+    case ZoneOp::Kind::Identity:
+        break;
+    case ZoneOp::Kind::Filter:
+        if (op.r != LLONG_MAX)
+            self().filter(op.x, 0, op.r);
+        if (op.l != LLONG_MIN)
+            self().filter(0, op.x, -op.l);
+        break;
+    case ZoneOp::Kind::Assign: {
+        // `x = y + c' only holds if it does not saturate, otherwise the
+        // relation is lost and `x' gets the saturated range
+        if (op.y != op.x) {
+            IntervalDomain interval = self().projection(op.y);
+            if (interval.l + op.c < 0 || interval.r + op.c > 255) {
+                self().assignInterval(
+                    op.x, std::clamp(interval.l + op.c, 0ll, 255ll),
+                    std::clamp(interval.r + op.c, 0ll, 255ll));
+                break;
+            }
+        }
+        self().assign(op.x, op.y, op.c);
+        break;
+    }
+    case ZoneOp::Kind::AssignInterval: {
+        long long l = op.l, r = op.r;
+        for (auto [v, sign] : {std::make_pair(op.y, op.sy),
+                               std::make_pair(op.z, op.sz)}) {
+            if (sign == 0)
+                continue;
+            IntervalDomain interval = self().projection(v);
+            l += sign > 0 ? interval.l : -interval.r;
+            r += sign > 0 ? interval.r : -interval.l;
+        }
+        // Saturation is monotone, so the bounds saturate
+        self().assignInterval(op.x, std::clamp(l, 0ll, 255ll),
+                              std::clamp(r, 0ll, 255ll));
+        break;
+    }
+    }
+}
+
+} // namespace fdlang::analysis
+
+#endif
@@ -15,7 +15,11 @@ void NopStmt::accept(ASTVisitor *visitor) { visitor->visit(this); }
 void Stmts::addChild(ASTNode *node) { children.push_back(node); }
 
 std::string fdlang::getASTNodeSpelling(const ASTNode &node) {
-    switch (node.type) {
+    return getASTNodeSpelling(node.type);
+}
+
+std::string fdlang::getASTNodeSpelling(ASTNodeType type) {
+    switch (type) {
     case ASTNodeType::STMTS:
         return "STMTS";
     case ASTNodeType::BINARY_ASSIGN_STMT:
@@ -153,6 +153,8 @@ public:
     virtual void accept(ASTVisitor *visitor) override;
 };
 
+std::string getASTNodeSpelling(ASTNodeType type);
+
 std::string getASTNodeSpelling(const ASTNode &node);
 
 } // namespace fdlang
@@ -8,27 +8,16 @@ void ASTTraversePrinter::visit(Stmts *node) {
     }
 }
 void ASTTraversePrinter::visit(Cond *node) {
-    out << node->leftOperand.lexeme << " ";
-    out << node->op.lexeme << " ";
-    out << node->rightOperand.lexeme;
+    printCond(node->leftOperand, node->op, node->rightOperand);
 }
 
 void ASTTraversePrinter::visit(UnaryAssignStmt *node) {
-    printIndent();
-    out << node->variable.lexeme << " = ";
-    out << node->operand.lexeme;
-    if (node->operand.type == TokenType::CALL_INPUT)
-        out << "()";
-    out << ";" << std::endl;
+    printUnaryAssign(node->variable, node->operand);
 }
 
 void ASTTraversePrinter::visit(BinaryAssignStmt *node) {
-    printIndent();
-    out << node->variable.lexeme << " = ";
-    out << node->leftOperand.lexeme << " ";
-    out << node->op.lexeme << " ";
-    out << node->rightOperand.lexeme << ";";
-    out << std::endl;
+    printBinaryAssign(node->variable, node->leftOperand, node->op,
+                      node->rightOperand);
 }
 
 void ASTTraversePrinter::visit(IfStmt *node) {
@@ -61,17 +50,104 @@ void ASTTraversePrinter::visit(WhileStmt *node) {
 }
 
 void ASTTraversePrinter::visit(CheckStmt *node) {
+    printCheck(node->check, node->params.data());
+}
+
+void ASTTraversePrinter::visit(NopStmt *node) {
     printIndent();
-    if (node->check.type == TokenType::CALL_CHECK_INTERVAL) {
-        out << node->check.lexeme << "(";
-        out << node->params[0].lexeme << ", ";
-        out << node->params[1].lexeme << ", ";
-        out << node->params[2].lexeme << ");";
+    out << "nop" << std::endl;
+}
+
+void ASTTraversePrinter::print(const FlatAST &ast, FlatAST::Index node) {
+    const Token *tokens = ast.getTokens(node);
+    switch (ast[node].type) {
+    case ASTNodeType::STMTS:
+        for (FlatAST::Index child = node + 1; child < ast[node].end;
+             child = ast[child].end)
+            print(ast, child);
+        break;
+    case ASTNodeType::COND:
+        printCond(tokens[0], tokens[1], tokens[2]);
+        break;
+    case ASTNodeType::UNARY_ASSIGN_STMT:
+        printUnaryAssign(tokens[0], tokens[1]);
+        break;
+    case ASTNodeType::BINARY_ASSIGN_STMT:
+        printBinaryAssign(tokens[0], tokens[1], tokens[2], tokens[3]);
+        break;
+    case ASTNodeType::IF_STMT:
+        printIndent();
+        out << "if (";
+        print(ast, ast.getChild(node, 0));
+        out << ") {" << std::endl;
+        ident++;
+        print(ast, ast.getChild(node, 1));
+        ident--;
+        printIndent();
+        out << "} else {" << std::endl;
+        ident++;
+        print(ast, ast.getChild(node, 2));
+        ident--;
+        printIndent();
+        out << "}" << std::endl;
+        break;
+    case ASTNodeType::WHILE_STMT:
+        printIndent();
+        out << "while (";
+        print(ast, ast.getChild(node, 0));
+        out << ") {" << std::endl;
+        ident++;
+        print(ast, ast.getChild(node, 1));
+        ident--;
+        printIndent();
+        out << "}" << std::endl;
+        break;
+    case ASTNodeType::CHECK_STMT:
+        printCheck(tokens[0], tokens + 1);
+        break;
+    case ASTNodeType::NOP_STMT:
+        printIndent();
+        out << "nop" << std::endl;
+        break;
     }
+}
+
+void ASTTraversePrinter::printCond(const Token &leftOperand, const Token &op,
+                                   const Token &rightOperand) {
+    out << leftOperand.lexeme << " ";
+    out << op.lexeme << " ";
+    out << rightOperand.lexeme;
+}
+
+void ASTTraversePrinter::printUnaryAssign(const Token &variable,
+                                          const Token &operand) {
+    printIndent();
+    out << variable.lexeme << " = ";
+    out << operand.lexeme;
+    if (operand.type == TokenType::CALL_INPUT)
+        out << "()";
+    out << ";" << std::endl;
+}
+
+void ASTTraversePrinter::printBinaryAssign(const Token &variable,
+                                           const Token &leftOperand,
+                                           const Token &op,
+                                           const Token &rightOperand) {
+    printIndent();
+    out << variable.lexeme << " = ";
+    out << leftOperand.lexeme << " ";
+    out << op.lexeme << " ";
+    out << rightOperand.lexeme << ";";
     out << std::endl;
 }
 
-void ASTTraversePrinter::visit(NopStmt *node) {
+void ASTTraversePrinter::printCheck(const Token &check, const Token *params) {
     printIndent();
-    out << "nop" << std::endl;
-}
\ No newline at end of file
+    if (check.type == TokenType::CALL_CHECK_INTERVAL) {
+        out << check.lexeme << "(";
+        out << params[0].lexeme << ", ";
+        out << params[1].lexeme << ", ";
+        out << params[2].lexeme << ");";
+    }
+    out << std::endl;
+}
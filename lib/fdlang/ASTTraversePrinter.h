@@ -2,6 +2,7 @@
 #define FDLANG_ASTTRAVERSEPRINTER_H
 
 #include "ASTVisitor.h"
+#include "flatAST.h"
 
 #include <iostream>
 
@@ -17,6 +18,13 @@ private:
             out << "    ";
     }
 
+    void printCond(const Token &leftOperand, const Token &op,
+                   const Token &rightOperand);
+    void printUnaryAssign(const Token &variable, const Token &operand);
+    void printBinaryAssign(const Token &variable, const Token &leftOperand,
+                           const Token &op, const Token &rightOperand);
+    void printCheck(const Token &check, const Token *params);
+
 public:
     ASTTraversePrinter(std::ostream &out) : out(out) {}
 
@@ -28,6 +36,11 @@ public:
     virtual void visit(WhileStmt *node) override;
     virtual void visit(CheckStmt *node) override;
     virtual void visit(NopStmt *node) override;
+
+    /**
+     * @brief Print the subtree of `node' in `ast', as the visitor does
+     */
+    void print(const FlatAST &ast, FlatAST::Index node = 0);
 };
 
 } // namespace fdlang
@@ -0,0 +1,70 @@
+#ifndef FDLANG_FLATAST_H
+#define FDLANG_FLATAST_H
+
+#include "AST.h"
+#include "token.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace fdlang {
+
+/**
+ * AST stored flat in two arrays, an alternative to the tree of `ASTNode'
+ *
+ * Nodes are in pre-order, each followed by its subtree, so the children of
+ * a node start right after it and each one ends where the next begins. The
+ * tokens of the nodes are contiguous in a second array, identifiers carry
+ * their `Symbol'. Nothing is allocated or freed per node and traversals are
+ * loops and switches on `ASTNodeType', with no virtual call.
+ *
+ * The root is node 0, the children and tokens of each type are
+ * - STMTS: the statements, no token
+ * - COND: no child, left operand, operator and right operand
+ * - UNARY_ASSIGN_STMT: no child, variable and operand
+ * - BINARY_ASSIGN_STMT: no child, variable, left operand, operator and
+ *   right operand
+ * - IF_STMT: COND, the true and false STMTS, no token
+ * - WHILE_STMT: COND and the body STMTS, no token
+ * - CHECK_STMT: no child, the call and its 3 parameters
+ * - NOP_STMT: nothing
+ */
+class FlatAST {
+public:
+    using Index = uint32_t;
+
+    struct Node {
+        ASTNodeType type;
+        uint32_t label;
+        // One past the last node of the subtree
+        Index end;
+        // First token of the node
+        Index token;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Token> tokens;
+
+    const Node &operator[](Index node) const { return nodes[node]; }
+
+    /**
+     * @brief Get the tokens of `node'
+     */
+    const Token *getTokens(Index node) const {
+        return tokens.data() + nodes[node].token;
+    }
+
+    /**
+     * @brief Get the `k'-th child of `node'
+     */
+    Index getChild(Index node, size_t k) const {
+        Index child = node + 1;
+        while (k--)
+            child = nodes[child].end;
+        return child;
+    }
+};
+
+} // namespace fdlang
+
+#endif
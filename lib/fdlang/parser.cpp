@@ -8,35 +8,104 @@ using namespace fdlang;
 
 ASTNode *Parser::parse() { return parseStmts(); }
 
-const Token &Parser::advance() {
+FlatAST Parser::parseFlat() {
+    FlatAST ast;
+    flat = &ast;
+    parseStmts();
+    flat = nullptr;
+    return ast;
+}
+
+FlatAST::Index Parser::openNode(ASTNodeType type) {
+    if (!flat)
+        return 0;
+    FlatAST::Index node = flat->nodes.size();
+    flat->nodes.push_back({type, 0, 0, FlatAST::Index(flat->tokens.size())});
+    return node;
+}
+
+ASTNode *Parser::closeNode(FlatAST::Index node, size_t label) {
+    flat->nodes[node].label = label;
+    flat->nodes[node].end = flat->nodes.size();
+    return nullptr;
+}
+
+ASTNode *Parser::addNode(ASTNodeType type, size_t label,
+                         std::initializer_list<Token> tokens) {
+    FlatAST::Index node = openNode(type);
+    for (const Token &token : tokens)
+        flat->tokens.push_back(token);
+    return closeNode(node, label);
+}
+
+ASTNode *Parser::parseTopLevel() {
+    // Label 0 is taken by the root of `parse'
+    if (label == 0)
+        label++;
+    // As in `parse', an unmatched } ends the program
+    if (isAtEnd() || hasError || peek().type == TokenType::RIGHT_BRACE)
+        return nullptr;
+    ASTNode *stmt = parseStmt();
+    if (hasError) {
+        delete stmt;
+        return nullptr;
+    }
+    return stmt;
+}
+
+Token Parser::advance() {
     if (isAtEnd()) {
-        hasError = true;
-        error(peek().line, "Parsing error, got EOF");
-        return tokens.back();
+        report(peek().line, "Parsing error, got EOF");
+        return peek();
     }
-    current++;
-    return tokens[current - 1];
+    last.emplace(window.front());
+    window.pop_front();
+    return *last;
 }
 
 bool Parser::isAtEnd() { return peek().type == TokenType::END_OF_FILE; }
 
-const Token &Parser::peek() { return tokens[current]; }
+const Token &Parser::peek(size_t ahead) {
+    while (window.size() <= ahead) {
+        if (!window.empty() && window.back().type == TokenType::END_OF_FILE)
+            return window.back();
+        window.push_back(scanner.next());
+        // Nothing is parsed past an error of the scanner, it reported it
+        if (scanner.hadError())
+            hasError = true;
+    }
+    return window[ahead];
+}
+
+Token Parser::previous() { return *last; }
 
-const Token &Parser::previous() { return tokens[current - 1]; }
+void Parser::report(size_t line, const std::string &message) {
+    hasError = true;
+    // The scanner reported its error, what follows from it is noise
+    if (!scanner.hadError())
+        error(line, message);
+}
 
 bool Parser::consume(TokenType type) {
-    const Token &token = advance();
+    Token token = advance();
     if (token.type != type) {
-        hasError = true;
-        error(peek().line, "Parsing error, expect " + getTokenSpelling(type) +
-                               " got " + peek().lexeme);
+        report(peek().line, "Parsing error, expect " + getTokenSpelling(type) +
+                                " got " + std::string(peek().lexeme));
         return false;
     }
     return true;
 }
 
 ASTNode *Parser::parseStmts() {
-    Stmts *stmts = new Stmts(label++);
+    size_t stmtsLabel = label++;
+    if (flat) {
+        FlatAST::Index node = openNode(ASTNodeType::STMTS);
+        while (!isAtEnd() && peek().type != TokenType::RIGHT_BRACE && !hasError)
+            parseStmt();
+        return closeNode(node, stmtsLabel);
+    }
+
+    Stmts *stmts = new Stmts(stmtsLabel);
     while (!isAtEnd() && peek().type != TokenType::RIGHT_BRACE && !hasError) {
         stmts->addChild(parseStmt());
     }
@@ -44,7 +113,7 @@ ASTNode *Parser::parseStmts() {
 }
 
 ASTNode *Parser::parseStmt() {
-    const Token &token = advance();
+    Token token = advance();
     switch (token.type) {
     case TokenType::IDENTIFIER:
         return parseAssignStmt();
@@ -57,26 +126,25 @@ ASTNode *Parser::parseStmt() {
     case TokenType::NOP:
         return parseNopStmt();
     default:
-        hasError = true;
-        error(token.line, "Parsing error, got " + token.lexeme);
+        report(token.line, "Parsing error, got " + std::string(token.lexeme));
         break;
     }
     return nullptr;
 }
 
 ASTNode *Parser::parseAssignStmt() {
-    if (current + 2 >= tokens.size()) {
-        hasError = true;
-        error(peek().line, "Parsing error, got " + peek().lexeme);
+    if (peek(1).type == TokenType::END_OF_FILE) {
+        report(peek().line, "Parsing error, got " + std::string(peek().lexeme));
         return nullptr;
     }
-    TokenType type = tokens[current + 2].type;
+    TokenType type = peek(2).type;
     if (type == TokenType::PLUS || type == TokenType::MINUS)
         return parseBinaryAssignStmt();
     return parseUnaryAssignStmt();
 }
 
 ASTNode *Parser::parseIfStmt() {
+    FlatAST::Index node = openNode(ASTNodeType::IF_STMT);
     if (!consume(TokenType::LEFT_PAREN))
         return nullptr;
     ASTNode *cond = parseCond();
@@ -100,10 +168,13 @@ ASTNode *Parser::parseIfStmt() {
         return nullptr;
     if (!consume(TokenType::RIGHT_BRACE))
         return nullptr;
+    if (flat)
+        return closeNode(node, label++);
     return new IfStmt(label++, cond, trueBody, falseBody);
 }
 
 ASTNode *Parser::parseWhileStmt() {
+    FlatAST::Index node = openNode(ASTNodeType::WHILE_STMT);
     if (!consume(TokenType::LEFT_PAREN))
         return nullptr;
     ASTNode *cond = parseCond();
@@ -118,55 +189,65 @@ ASTNode *Parser::parseWhileStmt() {
         return nullptr;
     if (!consume(TokenType::RIGHT_BRACE))
         return nullptr;
+    if (flat)
+        return closeNode(node, label++);
     return new WhileStmt(label++, cond, body);
 }
 
 ASTNode *Parser::parseCheckIntervalStmt() {
-    const Token &check = previous();
+    Token check = previous();
     if (!consume(TokenType::LEFT_PAREN))
         return nullptr;
-    const Token &param0 = advance();
+    Token param0 = advance();
     if (!consume(TokenType::COMMA))
         return nullptr;
-    const Token &param1 = advance();
+    Token param1 = advance();
     if (!consume(TokenType::COMMA))
         return nullptr;
-    const Token &param2 = advance();
+    Token param2 = advance();
     if (!consume(TokenType::RIGHT_PAREN))
         return nullptr;
     if (!consume(TokenType::SEMICOLON))
         return nullptr;
+    if (flat)
+        return addNode(ASTNodeType::CHECK_STMT, label++,
+                       {check, param0, param1, param2});
     return new CheckStmt(label++, check, {param0, param1, param2});
 }
 
 ASTNode *Parser::parseNopStmt() {
-    const Token &nop = previous();
+    Token nop = previous();
     if (!consume(TokenType::SEMICOLON))
         return nullptr;
+    if (flat)
+        return addNode(ASTNodeType::NOP_STMT, label++, {});
     return new NopStmt(label++);
 }
 
 ASTNode *Parser::parseBinaryAssignStmt() {
-    const Token &variable = previous();
+    Token variable = previous();
 
     if (!consume(TokenType::EQUAL))
         return nullptr;
-    const Token &leftOperand = advance();
-    const Token &op = advance();
-    const Token &rightOperand = advance();
+    Token leftOperand = advance();
+    Token op = advance();
+    Token rightOperand = advance();
     if (!consume(TokenType::SEMICOLON))
         return nullptr;
 
+    if (flat)
+        return addNode(ASTNodeType::BINARY_ASSIGN_STMT, label++,
+                       {variable, leftOperand, op, rightOperand});
     return new BinaryAssignStmt(label++, variable, leftOperand, op,
                                 rightOperand);
 }
 
 ASTNode *Parser::parseUnaryAssignStmt() {
-    const Token &variable = previous();
+    Token variable = previous();
 
     if (!consume(TokenType::EQUAL))
         return nullptr;
-    const Token &operand = advance();
+    Token operand = advance();
     if (operand.type == TokenType::CALL_INPUT) {
         if (!consume(TokenType::LEFT_PAREN))
             return nullptr;
@@ -176,14 +257,20 @@ ASTNode *Parser::parseUnaryAssignStmt() {
     if (!consume(TokenType::SEMICOLON))
         return nullptr;
 
+    if (flat)
+        return addNode(ASTNodeType::UNARY_ASSIGN_STMT, label++,
+                       {variable, operand});
     return new UnaryAssignStmt(label++, variable, operand);
 }
 
 ASTNode *Parser::parseCond() {
-    const Token &leftOperand = advance();
-    const Token &op = advance();
-    const Token &rightOperand = advance();
+    Token leftOperand = advance();
+    Token op = advance();
+    Token rightOperand = advance();
 
+    if (flat)
+        return addNode(ASTNodeType::COND, label++,
+                       {leftOperand, op, rightOperand});
     return new Cond(label++, leftOperand, op, rightOperand);
 }
 
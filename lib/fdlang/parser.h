@@ -2,32 +2,75 @@
 #define FDLANG_PARSER_H
 
 #include "AST.h"
+#include "flatAST.h"
+#include "scanner.h"
 #include "token.h"
 
-#include <vector>
+#include <deque>
+#include <initializer_list>
+#include <optional>
+#include <string>
 
 namespace fdlang {
 
+/**
+ * Recursive descent parser pulling its tokens from a `Scanner'
+ *
+ * Only the previous token and a lookahead of at most 3 are kept, so the
+ * memory of the parser is bounded by the nesting depth of the statement
+ * being parsed, not by the size of the source. `parse' builds the whole
+ * program, `parseTopLevel' hands out its statements one by one and
+ * `parseFlat' builds the whole program as a `FlatAST'.
+ */
 class Parser {
 private:
-    const std::vector<Token> tokens;
-    size_t start = 0;
-    size_t current = 0;
+    Scanner &scanner;
+    // The current token and the lookahead pulled so far
+    std::deque<Token> window;
+    std::optional<Token> last;
     size_t label = 0;
     bool hasError = false;
+    // Where the nodes go while `parseFlat' runs, the parse methods then
+    // return nullptr
+    FlatAST *flat = nullptr;
+
+    void report(size_t line, const std::string &message);
+
+    FlatAST::Index openNode(ASTNodeType type);
+
+    ASTNode *closeNode(FlatAST::Index node, size_t label);
+
+    ASTNode *addNode(ASTNodeType type, size_t label,
+                     std::initializer_list<Token> tokens);
 
 public:
-    Parser(const std::vector<Token> &tokens) : tokens(tokens) {}
+    Parser(Scanner &scanner) : scanner(scanner) {}
 
     ASTNode *parse();
 
-    const Token &advance();
+    /**
+     * @brief Parse the next top-level statement
+     *
+     * Return nullptr at the end of the source or on an error. The statements
+     * are labelled as by `parse', whose root takes label 0.
+     */
+    ASTNode *parseTopLevel();
+
+    /**
+     * @brief Parse the whole program into a `FlatAST'
+     *
+     * Labels are the ones `parse' gives, the result is meaningless if
+     * `hadError'.
+     */
+    FlatAST parseFlat();
+
+    Token advance();
 
     bool isAtEnd();
 
-    const Token &peek();
+    const Token &peek(size_t ahead = 0);
 
-    const Token &previous();
+    Token previous();
 
     bool consume(TokenType type);
 
@@ -56,4 +99,4 @@ public:
 
 } // namespace fdlang
 
-#endif
\ No newline at end of file
+#endif
@@ -1,12 +1,230 @@
 #include "scanner.h"
 #include "errorHandler.h"
 
-#include <cctype>
-#include <cstdlib>
+#include <array>
+#include <climits>
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SCANNER_X86_KERNELS
+#include <immintrin.h>
+#endif
 
 using namespace fdlang;
 
-const std::unordered_map<std::string, TokenType> Scanner::keywords = {
+namespace {
+
+// ASCII only, unlike <cctype> which depends on the locale
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool isAlpha(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+struct Kernels {
+    const char *name;
+    // Length of the run of whitespace from `p' to at most `end', the
+    // newlines of the run are added to `lines'
+    size_t (*spaces)(const char *p, const char *end, size_t &lines);
+    // Length of the run of letters, digits and underscores
+    size_t (*word)(const char *p, const char *end);
+    // Length of the run of digits
+    size_t (*digits)(const char *p, const char *end);
+};
+
+size_t spacesScalar(const char *p, const char *end, size_t &lines) {
+    const char *q = p;
+    for (; q < end && isSpace(*q); q++)
+        lines += *q == '\n';
+    return q - p;
+}
+
+size_t wordScalar(const char *p, const char *end) {
+    const char *q = p;
+    while (q < end && (isAlpha(*q) || isDigit(*q)))
+        q++;
+    return q - p;
+}
+
+size_t digitsScalar(const char *p, const char *end) {
+    const char *q = p;
+    while (q < end && isDigit(*q))
+        q++;
+    return q - p;
+}
+
+const Kernels scalarKernels = {"scalar", spacesScalar, wordScalar,
+                               digitsScalar};
+
+#ifdef SCANNER_X86_KERNELS
+
+// Each kernel tests whole vectors, the first byte out of the class ends the
+// run, and the tail shorter than a vector is left to the scalar kernel
+
+__attribute__((target("sse2"))) __m128i inRangeSSE2(__m128i v, char lo,
+                                                    char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+
+__attribute__((target("sse2"))) size_t spacesSSE2(const char *p,
+                                                  const char *end,
+                                                  size_t &lines) {
+    const char *q = p;
+    for (; end - q >= 16; q += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)q);
+        __m128i nl = _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+        __m128i space = _mm_or_si128(
+            _mm_or_si128(nl, _mm_cmpeq_epi8(v, _mm_set1_epi8(' '))),
+            _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')),
+                         _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+        uint32_t newlines = _mm_movemask_epi8(nl);
+        uint32_t other = ~_mm_movemask_epi8(space) & 0xffff;
+        if (other) {
+            uint32_t k = __builtin_ctz(other);
+            lines += __builtin_popcount(newlines & ((1u << k) - 1));
+            return q - p + k;
+        }
+        lines += __builtin_popcount(newlines);
+    }
+    return q - p + spacesScalar(q, end, lines);
+}
+
+__attribute__((target("sse2"))) size_t wordSSE2(const char *p,
+                                                const char *end) {
+    const char *q = p;
+    for (; end - q >= 16; q += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)q);
+        // Setting bit 5 folds the upper case letters onto the lower ones
+        __m128i word = _mm_or_si128(
+            _mm_or_si128(
+                inRangeSSE2(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z'),
+                inRangeSSE2(v, '0', '9')),
+            _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+        uint32_t other = ~_mm_movemask_epi8(word) & 0xffff;
+        if (other)
+            return q - p + __builtin_ctz(other);
+    }
+    return q - p + wordScalar(q, end);
+}
+
+__attribute__((target("sse2"))) size_t digitsSSE2(const char *p,
+                                                  const char *end) {
+    const char *q = p;
+    for (; end - q >= 16; q += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)q);
+        uint32_t other =
+            ~_mm_movemask_epi8(inRangeSSE2(v, '0', '9')) & 0xffff;
+        if (other)
+            return q - p + __builtin_ctz(other);
+    }
+    return q - p + digitsScalar(q, end);
+}
+
+__attribute__((target("avx2"))) __m256i inRangeAVX2(__m256i v, char lo,
+                                                    char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+}
+
+__attribute__((target("avx2"))) size_t spacesAVX2(const char *p,
+                                                  const char *end,
+                                                  size_t &lines) {
+    const char *q = p;
+    for (; end - q >= 32; q += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)q);
+        __m256i nl = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+        __m256i space = _mm256_or_si256(
+            _mm256_or_si256(nl, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' '))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')),
+                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+        uint32_t newlines = _mm256_movemask_epi8(nl);
+        uint32_t other = ~(uint32_t)_mm256_movemask_epi8(space);
+        if (other) {
+            uint32_t k = __builtin_ctz(other);
+            lines += __builtin_popcount(newlines & ((1ull << k) - 1));
+            return q - p + k;
+        }
+        lines += __builtin_popcount(newlines);
+    }
+    return q - p + spacesScalar(q, end, lines);
+}
+
+__attribute__((target("avx2"))) size_t wordAVX2(const char *p,
+                                                const char *end) {
+    const char *q = p;
+    for (; end - q >= 32; q += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)q);
+        __m256i word = _mm256_or_si256(
+            _mm256_or_si256(
+                inRangeAVX2(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a',
+                            'z'),
+                inRangeAVX2(v, '0', '9')),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        uint32_t other = ~(uint32_t)_mm256_movemask_epi8(word);
+        if (other)
+            return q - p + __builtin_ctz(other);
+    }
+    return q - p + wordScalar(q, end);
+}
+
+__attribute__((target("avx2"))) size_t digitsAVX2(const char *p,
+                                                  const char *end) {
+    const char *q = p;
+    for (; end - q >= 32; q += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)q);
+        uint32_t other =
+            ~(uint32_t)_mm256_movemask_epi8(inRangeAVX2(v, '0', '9'));
+        if (other)
+            return q - p + __builtin_ctz(other);
+    }
+    return q - p + digitsScalar(q, end);
+}
+
+const Kernels sse2Kernels = {"sse2", spacesSSE2, wordSSE2, digitsSSE2};
+const Kernels avx2Kernels = {"avx2", spacesAVX2, wordAVX2, digitsAVX2};
+
+#endif
+
+const Kernels *kernelsFor(ScanKernel kernel) {
+    switch (kernel) {
+    case ScanKernel::Scalar:
+        return &scalarKernels;
+#ifdef SCANNER_X86_KERNELS
+    case ScanKernel::SSE2:
+        return __builtin_cpu_supports("sse2") ? &sse2Kernels : nullptr;
+    case ScanKernel::AVX2:
+        return __builtin_cpu_supports("avx2") ? &avx2Kernels : nullptr;
+    case ScanKernel::Best:
+        // May run before the constructors of libgcc
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            return &avx2Kernels;
+        if (__builtin_cpu_supports("sse2"))
+            return &sse2Kernels;
+        return &scalarKernels;
+#else
+    case ScanKernel::Best:
+        return &scalarKernels;
+#endif
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+const Kernels *active = kernelsFor(ScanKernel::Best);
+
+struct Keyword {
+    std::string_view name;
+    TokenType type = TokenType::IDENTIFIER;
+};
+
+constexpr Keyword keywords[] = {
     {"if", TokenType::IF},
     {"else", TokenType::ELSE},
     {"while", TokenType::WHILE},
@@ -14,13 +232,54 @@ const std::unordered_map<std::string, TokenType> Scanner::keywords = {
     {"check_interval", TokenType::CALL_CHECK_INTERVAL},
     {"nop", TokenType::NOP}};
 
-std::vector<Token> Scanner::scanTokens() {
-    while (!isAtEnd()) {
+// Perfect hash of the keywords, found by search, so a word is a keyword iff
+// it equals the one in its slot
+constexpr size_t KEYWORD_SLOTS = 16;
+
+constexpr size_t keywordSlot(std::string_view word) {
+    return ((unsigned char)word[0] * 2 + (unsigned char)word.back() +
+            word.size()) %
+           KEYWORD_SLOTS;
+}
+
+constexpr std::array<Keyword, KEYWORD_SLOTS> makeKeywordTable() {
+    std::array<Keyword, KEYWORD_SLOTS> table{};
+    for (const Keyword &keyword : keywords)
+        table[keywordSlot(keyword.name)] = keyword;
+    return table;
+}
+
+constexpr std::array<Keyword, KEYWORD_SLOTS> keywordTable = makeKeywordTable();
+
+constexpr bool keywordsHashPerfectly() {
+    for (const Keyword &keyword : keywords)
+        if (keywordTable[keywordSlot(keyword.name)].name != keyword.name)
+            return false;
+    return true;
+}
+
+static_assert(keywordsHashPerfectly(), "Two keywords share a slot");
+
+} // namespace
+
+Token Scanner::next() {
+    token.reset();
+    while (!token && !isAtEnd()) {
         start = current;
         scanToken();
     }
+    if (!token)
+        return Token(TokenType::END_OF_FILE, "", 0, line);
+    return *token;
+}
 
-    tokens.emplace_back(TokenType::END_OF_FILE, "", nullptr, line);
+std::vector<Token> Scanner::scanTokens() {
+    std::vector<Token> tokens;
+    // Tokens take a few bytes each, so this saves most of the regrowth
+    tokens.reserve((source.size() - current) / 4 + 1);
+    do
+        tokens.push_back(next());
+    while (tokens.back().type != TokenType::END_OF_FILE);
     return tokens;
 }
 
@@ -63,17 +322,17 @@ void Scanner::scanToken() {
     case ' ':
     case '\t':
     case '\r':
-        break;
     case '\n':
-        line++;
+        whitespace();
         break;
     default:
-        if (std::isdigit(c)) {
+        if (isDigit(c)) {
             number();
-        } else if (std::isalpha(c) || c == '_') {
+        } else if (isAlpha(c)) {
             identifier();
         } else {
-            error(line, "Unexpected character " + std::string(c, 1));
+            error(line, "Unexpected character " + std::string(1, c));
+            hasError = true;
         }
         break;
     }
@@ -86,11 +345,10 @@ char Scanner::advance() {
 
 bool Scanner::isAtEnd() { return current >= source.size(); }
 
-void Scanner::addToken(TokenType type) { addToken(type, nullptr); }
+void Scanner::addToken(TokenType type) { addToken(type, 0); }
 
-void Scanner::addToken(TokenType type, const std::any &literal) {
-    std::string text = source.substr(start, current - start);
-    tokens.emplace_back(type, text, literal, line);
+void Scanner::addToken(TokenType type, long long literal) {
+    token.emplace(type, source.substr(start, current - start), literal, line);
 }
 
 bool Scanner::match(char expected) {
@@ -109,24 +367,44 @@ char Scanner::peek() {
     return source[current];
 }
 
+void Scanner::whitespace() {
+    const char *end = source.data() + source.size();
+    current = start + active->spaces(source.data() + start, end, line);
+}
+
 void Scanner::number() {
-    while (std::isdigit(peek()))
-        advance();
+    const char *end = source.data() + source.size();
+    current = start + active->digits(source.data() + start, end);
 
-    long long num = std::stoll(source.substr(start, current - start));
+    // Saturated, values above 255 are rejected or saturated later anyway
+    long long num = 0;
+    for (size_t i = start; i < current; i++) {
+        int digit = source[i] - '0';
+        num = num > (LLONG_MAX - digit) / 10 ? LLONG_MAX : num * 10 + digit;
+    }
     addToken(TokenType::NUMBER, num);
 }
 
 void Scanner::identifier() {
-    while (std::isalnum(peek()) || peek() == '_')
-        advance();
+    const char *end = source.data() + source.size();
+    current = start + active->word(source.data() + start, end);
 
-    std::string text = source.substr(start, current - start);
-    auto it = keywords.find(text);
-    if (it == keywords.end())
-        addToken(TokenType::IDENTIFIER);
+    std::string_view text = source.substr(start, current - start);
+    const Keyword &keyword = keywordTable[keywordSlot(text)];
+    if (keyword.name == text)
+        addToken(keyword.type);
     else
-        addToken(it->second);
+        addToken(TokenType::IDENTIFIER, SymbolTable::get().intern(text));
+}
+
+bool Scanner::hadError() { return hasError; }
+
+bool Scanner::useKernel(ScanKernel kernel) {
+    const Kernels *k = kernelsFor(kernel);
+    if (!k)
+        return false;
+    active = k;
+    return true;
 }
 
-bool Scanner::hadError() { return hasError; }
\ No newline at end of file
+const char *Scanner::kernelName() { return active->name; }
\ No newline at end of file
@@ -3,28 +3,67 @@
 
 #include "token.h"
 
-#include <unordered_map>
+#include <optional>
+#include <string_view>
 #include <vector>
 
 namespace fdlang {
+
+/**
+ * Instruction sets the scanner kernels can be built for. `Best' picks the
+ * widest one supported by the running CPU.
+ */
+enum class ScanKernel { Scalar, SSE2, AVX2, Best };
+
+/**
+ * Scanner of a source into tokens pointing into it
+ *
+ * The source is not copied, it has to outlive the scanner and the tokens,
+ * and nothing is allocated per token. Tokens are either pulled one by one
+ * with `next', or all at once with `scanTokens'.
+ *
+ * Runs of whitespace, identifiers and numbers are each found by one kernel
+ * call, which classifies 16 or 32 bytes at a time, and keywords are matched
+ * by a perfect hash.
+ */
 class Scanner {
 private:
-    std::string source;
-    std::vector<Token> tokens;
+    std::string_view source;
+    // The token found by the last `scanToken', if any
+    std::optional<Token> token;
     size_t start = 0;
     size_t current = 0;
     size_t line = 1;
     bool hasError = false;
 
-    static const std::unordered_map<std::string, TokenType> keywords;
-
 public:
-    Scanner(const std::string &source) : source(source) {}
+    Scanner(std::string_view source) : source(source) {}
+
+    /**
+     * @brief Scan the next token, END_OF_FILE once the source is exhausted
+     */
+    Token next();
 
+    /**
+     * @brief Scan the remaining tokens, ending with END_OF_FILE
+     */
     std::vector<Token> scanTokens();
 
     bool hadError();
 
+    /**
+     * @brief Select the kernels used by every scanner
+     *
+     * Return false and keep the current kernels if `kernel' is not supported
+     * by the running CPU.
+     */
+    static bool useKernel(ScanKernel kernel);
+
+    /**
+     * @brief Get the name of the kernels in use
+     */
+    static const char *kernelName();
+
 private:
     void scanToken();
 
@@ -34,12 +73,14 @@ private:
 
     void addToken(TokenType type);
 
-    void addToken(TokenType type, const std::any &literal);
+    void addToken(TokenType type, long long literal);
 
     bool match(char expected);
 
     char peek();
 
+    void whitespace();
+
     void number();
 
     void identifier();
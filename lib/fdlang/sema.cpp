@@ -40,30 +40,34 @@ void Sema::visit(WhileStmt *node) {
 }
 
 void Sema::visit(CheckStmt *node) {
-    switch (node->check.type) {
+    checkCall(node->check, node->params.data());
+}
+
+void Sema::visit(NopStmt *node) {}
+
+void Sema::checkCall(const Token &call, const Token *params) {
+    switch (call.type) {
     case TokenType::CALL_CHECK_INTERVAL: {
-        checkVariable(node->params[0]);
-        checkNumber(node->params[1]);
-        checkNumber(node->params[2]);
+        checkVariable(params[0]);
+        checkNumber(params[1]);
+        checkNumber(params[2]);
         break;
     }
     default:
         hasError = true;
-        error(node->check.line, "Sema error, expect CALL_CHECK got " +
-                                    getTokenSpelling(node->check.type) + "(" +
-                                    node->check.lexeme + ")");
+        error(call.line, "Sema error, expect CALL_CHECK got " +
+                             getTokenSpelling(call.type) + "(" +
+                             std::string(call.lexeme) + ")");
     }
 }
 
-void Sema::visit(NopStmt *node) {}
-
 bool Sema::checkVariable(const Token &token) {
     if (token.type != TokenType::IDENTIFIER) {
         hasError = true;
         error(token.line, "Sema error, expect " +
                               getTokenSpelling(TokenType::IDENTIFIER) +
                               " got " + getTokenSpelling(token.type) + "(" +
-                              token.lexeme + ")");
+                              std::string(token.lexeme) + ")");
         return false;
     }
     return true;
@@ -74,7 +78,7 @@ bool Sema::checkCondOp(const Token &token) {
         hasError = true;
         error(token.line, "Sema error, expect CONDITIONAL_OPERATOR got " +
                               getTokenSpelling(token.type) + "(" +
-                              token.lexeme + ")");
+                              std::string(token.lexeme) + ")");
         return false;
     }
     return true;
@@ -86,7 +90,7 @@ bool Sema::checkNumber(const Token &token) {
         error(token.line, "Sema error, expect " +
                               getTokenSpelling(TokenType::NUMBER) + " got " +
                               getTokenSpelling(token.type) + "(" +
-                              token.lexeme + ")");
+                              std::string(token.lexeme) + ")");
         return false;
     }
     long long val = token.getLiteralAsNumber();
@@ -103,7 +107,7 @@ bool Sema::checkArithmeticOp(const Token &token) {
         hasError = true;
         error(token.line, "Sema error, expect ARITHEMETIC_OPERATOR got " +
                               getTokenSpelling(token.type) + "(" +
-                              token.lexeme + ")");
+                              std::string(token.lexeme) + ")");
         return false;
     }
     return true;
@@ -114,7 +118,7 @@ bool Sema::checkValue(const Token &token) {
         hasError = true;
         error(token.line, "Sema error, expect VALUE got " +
                               getTokenSpelling(token.type) + "(" +
-                              token.lexeme + ")");
+                              std::string(token.lexeme) + ")");
         return false;
     }
     return true;
@@ -125,13 +129,42 @@ bool Sema::checkValueOrInput(const Token &token) {
         hasError = true;
         error(token.line, "Sema error, expect VALUE or CALL_INPUT got " +
                               getTokenSpelling(token.type) + "(" +
-                              token.lexeme + ")");
+                              std::string(token.lexeme) + ")");
         return false;
     }
     return true;
 }
 
 bool Sema::check() {
-    root->accept(this);
+    if (!flat) {
+        root->accept(this);
+        return !hasError;
+    }
+
+    for (FlatAST::Index node = 0; node < flat->nodes.size(); node++) {
+        const Token *tokens = flat->getTokens(node);
+        switch ((*flat)[node].type) {
+        case ASTNodeType::COND:
+            checkVariable(tokens[0]);
+            checkCondOp(tokens[1]);
+            checkNumber(tokens[2]);
+            break;
+        case ASTNodeType::UNARY_ASSIGN_STMT:
+            checkVariable(tokens[0]);
+            checkValueOrInput(tokens[1]);
+            break;
+        case ASTNodeType::BINARY_ASSIGN_STMT:
+            checkVariable(tokens[0]);
+            checkValue(tokens[1]);
+            checkArithmeticOp(tokens[2]);
+            checkValue(tokens[3]);
+            break;
+        case ASTNodeType::CHECK_STMT:
+            checkCall(tokens[0], tokens + 1);
+            break;
+        default:
+            break;
+        }
+    }
     return !hasError;
 }
\ No newline at end of file
@@ -3,12 +3,20 @@
 
 #include "AST.h"
 #include "ASTVisitor.h"
+#include "flatAST.h"
 
 namespace fdlang {
 
+/**
+ * Checks of the operands of each statement, on an AST or a `FlatAST'
+ *
+ * No check depends on the enclosing statements, so the flat nodes are
+ * checked in one pass over the array, in the order of the tree traversal.
+ */
 class Sema : public ASTVisitor {
 private:
-    ASTNode *root;
+    ASTNode *root = nullptr;
+    const FlatAST *flat = nullptr;
     bool hasError = false;
 
     void visit(Stmts *node) override;
@@ -20,6 +28,7 @@ private:
     void visit(CheckStmt *node) override;
     void visit(NopStmt *node) override;
 
+    void checkCall(const Token &call, const Token *params);
     bool checkVariable(const Token &token);
     bool checkCondOp(const Token &token);
     bool checkNumber(const Token &token);
@@ -30,6 +39,8 @@ private:
 public:
     Sema(ASTNode *root) : root(root) {}
 
+    Sema(const FlatAST &ast) : flat(&ast) {}
+
     bool check();
 };
 
@@ -0,0 +1,44 @@
+#include "sourceBuffer.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace fdlang;
+
+SourceBuffer::SourceBuffer(const std::string &path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            data = static_cast<const char *>(p);
+            size = st.st_size;
+            mapped = opened = true;
+            close(fd);
+            return;
+        }
+    }
+
+    // Not mappable, read it whole
+    char chunk[1 << 16];
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0)
+        copy.append(chunk, n);
+    close(fd);
+    if (n < 0)
+        return;
+    data = copy.data();
+    size = copy.size();
+    opened = true;
+}
+
+SourceBuffer::~SourceBuffer() {
+    if (mapped)
+        munmap(const_cast<char *>(data), size);
+}
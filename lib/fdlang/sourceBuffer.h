@@ -0,0 +1,46 @@
+#ifndef FDLANG_SOURCEBUFFER_H
+#define FDLANG_SOURCEBUFFER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace fdlang {
+
+/**
+ * Read-only contents of a source file
+ *
+ * A regular file is mapped into memory and never copied, so the scanner
+ * reads the pages of the file directly. Anything else, like a pipe, is read
+ * into a string. The tokens point into the buffer, which has to outlive
+ * them and everything built from them.
+ */
+class SourceBuffer {
+private:
+    const char *data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+    bool opened = false;
+
+    // Contents of the files which cannot be mapped
+    std::string copy;
+
+public:
+    explicit SourceBuffer(const std::string &path);
+
+    ~SourceBuffer();
+
+    SourceBuffer(const SourceBuffer &) = delete;
+    SourceBuffer &operator=(const SourceBuffer &) = delete;
+
+    /**
+     * @brief Test if the file could be read
+     */
+    bool isOpen() const { return opened; }
+
+    std::string_view text() const { return {data, size}; }
+};
+
+} // namespace fdlang
+
+#endif
@@ -0,0 +1,23 @@
+#include "symbolTable.h"
+
+using namespace fdlang;
+
+SymbolTable &SymbolTable::get() {
+    static SymbolTable table;
+    return table;
+}
+
+Symbol SymbolTable::intern(std::string_view name) {
+    auto it = symbols.find(name);
+    if (it != symbols.end())
+        return it->second;
+    Symbol symbol = names.size();
+    names.emplace_back(name);
+    symbols.emplace(names.back(), symbol);
+    return symbol;
+}
+
+Symbol SymbolTable::lookup(std::string_view name) const {
+    auto it = symbols.find(name);
+    return it == symbols.end() ? NONE : it->second;
+}
@@ -0,0 +1,63 @@
+#ifndef FDLANG_SYMBOLTABLE_H
+#define FDLANG_SYMBOLTABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace fdlang {
+
+// Dense id of an identifier in the `SymbolTable'
+using Symbol = uint32_t;
+
+/**
+ * Identifiers of all the sources scanned by the process
+ *
+ * The scanner interns each identifier once, everything after it compares
+ * and indexes variables by their `Symbol', from 0 in the order they are
+ * first seen, and only printing goes back to the names. Interning is not
+ * thread-safe.
+ */
+class SymbolTable {
+private:
+    // Names stay in place, the keys of `symbols' are views of them
+    std::deque<std::string> names;
+    std::unordered_map<std::string_view, Symbol> symbols;
+
+    SymbolTable() = default;
+
+public:
+    SymbolTable(const SymbolTable &) = delete;
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+    /**
+     * @brief Get the table of the process
+     */
+    static SymbolTable &get();
+
+    static constexpr Symbol NONE = UINT32_MAX;
+
+    /**
+     * @brief Get the symbol of `name', allocating the next one if it is new
+     */
+    Symbol intern(std::string_view name);
+
+    /**
+     * @brief Get the symbol of `name', NONE if it was never interned
+     */
+    Symbol lookup(std::string_view name) const;
+
+    const std::string &getName(Symbol symbol) const { return names[symbol]; }
+
+    /**
+     * @brief Get the number of symbols, which are all below it
+     */
+    size_t size() const { return names.size(); }
+};
+
+} // namespace fdlang
+
+#endif
@@ -1,6 +1,5 @@
 #include "token.h"
 
-#include <any>
 #include <assert.h>
 
 using namespace fdlang;
@@ -61,7 +60,12 @@ std::string fdlang::getTokenSpelling(TokenType type) {
 
 long long Token::getLiteralAsNumber() const {
     assert(type == TokenType::NUMBER);
-    return std::any_cast<long long>(literal);
+    return literal;
+}
+
+Symbol Token::getSymbol() const {
+    assert(type == TokenType::IDENTIFIER);
+    return literal;
 }
 
 bool Token::isCondOp() const {
@@ -1,8 +1,12 @@
 #ifndef FDLANG_TOKEN_H
 #define FDLANG_TOKEN_H
 
-#include <any>
+#include "symbolTable.h"
+
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
 
 namespace fdlang {
 
@@ -40,18 +44,27 @@ enum class TokenType {
     END_OF_FILE
 };
 
+/**
+ * Token of a source, 32 bytes without any allocation
+ *
+ * The lexeme points into the scanned source, which has to outlive the
+ * token. Numbers carry their value, saturated to LLONG_MAX, identifiers
+ * their `Symbol', others 0.
+ */
 struct Token {
     const TokenType type;
-    const std::string lexeme;
-    const std::any literal;
-    const size_t line;
+    const uint32_t line;
+    const std::string_view lexeme;
+    const long long literal;
 
-    Token(TokenType type, const std::string &lexeme, const std::any &literal,
+    Token(TokenType type, std::string_view lexeme, long long literal,
           size_t line)
-        : type(type), lexeme(lexeme), literal(literal), line(line) {}
+        : type(type), line(line), lexeme(lexeme), literal(literal) {}
 
     long long getLiteralAsNumber() const;
 
+    Symbol getSymbol() const;
+
     bool isCondOp() const;
 
     bool isArithmeticOp() const;
@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+
+#include "analysis/dbm.h"
+
+#include <cstdint>
+#include <random>
+
+using namespace fdlang::analysis;
+
+// Random matrix without negative cycles: `w(i, j) = p[j] - p[i] + d' for
+// potentials `p' and some `d >= 0', so negative entries appear as well
+DBM randomDBM(size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> potential(0, 255), slack(0, 64);
+    std::uniform_real_distribution<double> coin(0, 1);
+    std::vector<int> p(n);
+    for (auto &v : p)
+        v = potential(rng);
+
+    DBM m(n, DBM::INF);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            if (i == j)
+                m[i][j] = 0;
+            else if (coin(rng) < 0.1)
+                m[i][j] = p[j] - p[i] + slack(rng);
+    return m;
+}
+
+TEST(DBM, BlockedClosureMatchesPlain) {
+    for (size_t n : {1, 127, 128, 129, 300}) {
+        DBM plain = randomDBM(n, n);
+        DBM::useThreads(1, SIZE_MAX);
+        plain.close();
+
+        for (size_t threads : {2, 4}) {
+            DBM blocked = randomDBM(n, n);
+            DBM::useThreads(threads, 1);
+            blocked.close();
+            EXPECT_TRUE(blocked.eq(plain)) << n << " " << threads;
+        }
+    }
+    DBM::useThreads(1);
+}
+
+TEST(DBM, BlockedClosureOfBandMatchesPlain) {
+    // Only entries near the diagonal are finite, so most tiles are INF
+    size_t n = 600, band = 40;
+    DBM plain = randomDBM(n, 7);
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            if (i + band < j || j + band < i)
+                plain[i][j] = DBM::INF;
+    DBM blocked = plain;
+
+    DBM::useThreads(1, SIZE_MAX);
+    plain.close();
+    DBM::useThreads(4, 1);
+    blocked.close();
+    EXPECT_TRUE(blocked.eq(plain));
+    DBM::useThreads(1);
+}
+
+TEST(DBM, KernelsAgreeOnNegativeCycle) {
+    // Sums along the cycle run far below -INF, every kernel has to clamp them
+    // to -INF as the scalar one does
+    size_t n = 40;
+    DBM cycle = randomDBM(n, 3);
+    for (size_t i = 0; i < n; i++)
+        cycle[i][(i + 1) % n] = -20000;
+
+    ASSERT_TRUE(DBM::useKernel(DBMKernel::Scalar));
+    DBM scalar = cycle;
+    scalar.close();
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < n; j++)
+            ASSERT_GE(scalar[i][j], -DBM::INF);
+
+    for (DBMKernel kernel : {DBMKernel::SSE41, DBMKernel::AVX2}) {
+        if (!DBM::useKernel(kernel))
+            continue;
+        DBM vector = cycle;
+        vector.close();
+        EXPECT_TRUE(vector.eq(scalar)) << DBM::kernelName();
+    }
+    DBM::useKernel(DBMKernel::Best);
+}
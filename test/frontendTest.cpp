@@ -0,0 +1,156 @@
+#include "gtest/gtest.h"
+
+#include "fdlang/AST.h"
+#include "fdlang/ASTTraversePrinter.h"
+#include "fdlang/flatAST.h"
+#include "fdlang/parser.h"
+#include "fdlang/scanner.h"
+#include "fdlang/sema.h"
+
+#include "analysis/modelChecker.h"
+
+#include "IR/IRBuilder.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace fdlang;
+
+std::string readSrc(const std::string &path) {
+    std::ifstream file(path);
+    file.seekg(0, std::ios::end);
+    std::streamoff fileLength = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    char *buffer = new char[fileLength + 1];
+    file.read(buffer, fileLength);
+    buffer[fileLength] = '\0';
+    std::string ret = buffer;
+
+    if (buffer)
+        delete[] buffer;
+
+    return ret;
+}
+
+std::string dumpIR(fdlang::IR::Insts &insts) {
+    std::stringstream out;
+    for (auto inst : insts) {
+        inst->dump(out);
+        out << "\n";
+        for (auto succ : inst->getSuccessors())
+            out << " -> " << succ->getLabel();
+        out << "\n";
+    }
+    return out.str();
+}
+
+TEST(IRBuilder, StreamingMatchesWholeAST) {
+    std::vector<std::string> files = {
+        "branch1.fdlang", "corner.fdlang", "deadcode2.fdlang", "loop4.fdlang",
+        "nobranch3.fdlang", "rel4.fdlang"};
+
+    for (auto &filepath : files) {
+        std::string src = readSrc(TESTCASES_DIR "/" + filepath);
+
+        fdlang::Scanner scanner(src);
+        fdlang::Parser parser(scanner);
+        fdlang::ASTNode *root = parser.parse();
+        fdlang::IR::IRBuilder irBuilder(root);
+        fdlang::IR::Insts insts = irBuilder.build();
+
+        fdlang::Scanner streamScanner(src);
+        fdlang::Parser streamParser(streamScanner);
+        fdlang::IR::IRBuilder streamBuilder;
+        ASSERT_TRUE(streamBuilder.stream(streamParser)) << filepath;
+        fdlang::IR::Insts streamInsts = streamBuilder.finish();
+
+        EXPECT_EQ(dumpIR(streamInsts), dumpIR(insts)) << filepath;
+        delete root;
+    }
+}
+
+TEST(IRBuilder, StreamingReportsErrors) {
+    for (std::string src : {"a = 1;\ncheck_interval(a, 0, 300);\nc = a;\n",
+                            "a = 1;\nif (a > 0) {\nb = 1;\n",
+                            "a = 1;\nb = a $ 2;\n"}) {
+        fdlang::Scanner scanner(src);
+        fdlang::Parser parser(scanner);
+        fdlang::IR::IRBuilder irBuilder;
+        EXPECT_FALSE(irBuilder.stream(parser)) << src;
+    }
+}
+
+TEST(FlatAST, MatchesTree) {
+    std::vector<std::string> files = {
+        "branch1.fdlang", "corner.fdlang",    "deadcode1.fdlang",
+        "loop1.fdlang",   "nobranch1.fdlang", "rel2.fdlang"};
+
+    for (auto &filepath : files) {
+        std::string src = readSrc(TESTCASES_DIR "/" + filepath);
+        std::stringstream tree, flat;
+
+        fdlang::Scanner scanner(src);
+        fdlang::Parser parser(scanner);
+        fdlang::ASTNode *root = parser.parse();
+        ASSERT_TRUE(fdlang::Sema(root).check());
+        fdlang::ASTTraversePrinter printer(tree);
+        root->accept(&printer);
+        fdlang::analysis::NaiveModelChecker modelChecker(root);
+        modelChecker.run();
+        modelChecker.dumpResult(tree);
+        fdlang::IR::IRBuilder irBuilder(root);
+        fdlang::IR::Insts insts = irBuilder.build();
+        tree << dumpIR(insts);
+
+        fdlang::Scanner flatScanner(src);
+        fdlang::Parser flatParser(flatScanner);
+        fdlang::FlatAST ast = flatParser.parseFlat();
+        ASSERT_FALSE(flatParser.hadError());
+        ASSERT_TRUE(fdlang::Sema(ast).check());
+        fdlang::ASTTraversePrinter flatPrinter(flat);
+        flatPrinter.print(ast);
+        fdlang::analysis::NaiveModelChecker flatModelChecker(ast);
+        flatModelChecker.run();
+        flatModelChecker.dumpResult(flat);
+        fdlang::IR::IRBuilder flatBuilder(ast);
+        fdlang::IR::Insts flatInsts = flatBuilder.build();
+        flat << dumpIR(flatInsts);
+
+        EXPECT_EQ(flat.str(), tree.str()) << filepath;
+        delete root;
+    }
+}
+
+TEST(FlatAST, Layout) {
+    std::string src = "while (a < 3) {\nif (a > 1) {\nnop;\n} else {\n"
+                      "a = a + 1;\n}\n}\ncheck_interval(a, 0, 3);\n";
+    fdlang::Scanner scanner(src);
+    fdlang::Parser parser(scanner);
+    fdlang::FlatAST ast = parser.parseFlat();
+    ASSERT_FALSE(parser.hadError());
+
+    // Pre-order, each node followed by its subtree
+    std::vector<ASTNodeType> types;
+    for (auto &node : ast.nodes)
+        types.push_back(node.type);
+    EXPECT_EQ(types, (std::vector<ASTNodeType>{
+                         ASTNodeType::STMTS, ASTNodeType::WHILE_STMT,
+                         ASTNodeType::COND, ASTNodeType::STMTS,
+                         ASTNodeType::IF_STMT, ASTNodeType::COND,
+                         ASTNodeType::STMTS, ASTNodeType::NOP_STMT,
+                         ASTNodeType::STMTS, ASTNodeType::BINARY_ASSIGN_STMT,
+                         ASTNodeType::CHECK_STMT}));
+    EXPECT_EQ(ast[0].end, ast.nodes.size());
+    EXPECT_EQ(ast[1].end, 10u);
+    EXPECT_EQ(ast.getChild(0, 1), 10u);
+    EXPECT_EQ(ast.getChild(4, 2), 8u);
+    EXPECT_EQ(ast.getTokens(10)[2].getLiteralAsNumber(), 0);
+
+    fdlang::Scanner badScanner("a = 1;\ncheck_interval(a, 0, 300);\n");
+    fdlang::Parser badParser(badScanner);
+    fdlang::FlatAST bad = badParser.parseFlat();
+    EXPECT_FALSE(fdlang::Sema(bad).check());
+}
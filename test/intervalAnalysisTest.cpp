@@ -6,13 +6,20 @@
 #include "fdlang/scanner.h"
 #include "fdlang/sema.h"
 
+#include "analysis/defUseGraph.h"
+#include "analysis/fastIntervalAnalysis.h"
 #include "analysis/intervalAnalysis.h"
 #include "analysis/modelChecker.h"
+#include "analysis/valueSet.h"
+#include "analysis/varRange.h"
 
 #include "IR/IRBuilder.h"
 
+#include <algorithm>
+#include <bitset>
 #include <fstream>
 #include <iostream>
+#include <random>
 #include <sstream>
 
 using namespace fdlang;
@@ -77,11 +84,9 @@ void check(std::string &filepath) {
     std::stringstream result;
 
     fdlang::Scanner scanner(src);
-    std::vector<fdlang::Token> tokens = scanner.scanTokens();
-    EXPECT_FALSE(scanner.hadError());
-
-    fdlang::Parser parser(tokens);
+    fdlang::Parser parser(scanner);
     fdlang::ASTNode *root = parser.parse();
+    EXPECT_FALSE(scanner.hadError());
     EXPECT_FALSE(parser.hadError());
 
     fdlang::Sema sema(root);
@@ -121,4 +126,318 @@ TEST(IntervalAnalysis, RunAll) {
     if (true_positive + false_negtive == 0)
         recall = 0;
     printf("Recall: %.3lf%%\n", recall);
-}
\ No newline at end of file
+}
+
+using Mode = analysis::IntervalAnalysis::Mode;
+
+std::string runAnalysis(const std::string &src, size_t *iterations = nullptr,
+                        Mode mode = Mode::Dense,
+                        size_t narrowingRounds =
+                            analysis::IntervalAnalysis::NARROWING_ROUNDS) {
+    std::stringstream result;
+
+    fdlang::Scanner scanner(src);
+    fdlang::Parser parser(scanner);
+    fdlang::ASTNode *root = parser.parse();
+    EXPECT_FALSE(scanner.hadError());
+    EXPECT_FALSE(parser.hadError());
+
+    fdlang::Sema sema(root);
+    EXPECT_TRUE(sema.check());
+
+    fdlang::IR::IRBuilder irBuilder(root);
+    fdlang::IR::Insts insts = irBuilder.build();
+
+    fdlang::analysis::IntervalAnalysis analysis(insts, mode, narrowingRounds);
+    analysis.run();
+    analysis.dumpResult(result);
+    if (iterations)
+        *iterations = analysis.getIterations();
+
+    return result.str();
+}
+
+TEST(IntervalAnalysis, LoopCostIgnoresStraightLineCode) {
+    // `prefix' assignments, then a loop which runs to a fixpoint
+    auto iterations = [](size_t prefix) {
+        std::string src;
+        for (size_t i = 0; i < prefix; i++)
+            src += "v" + std::to_string(i % 7) + " = " +
+                   std::to_string(i % 200) + ";\n";
+        src += "i = 0;\nwhile (i < 20) {\ni = i + 1;\n}\n"
+               "check_interval(i, 20, 20);\n";
+
+        size_t iterations;
+        EXPECT_EQ(runAnalysis(src, &iterations),
+                  "Line " + std::to_string(prefix + 5) + ": YES\n");
+        return iterations;
+    };
+
+    // Every assignment before the loop is transferred once
+    EXPECT_EQ(iterations(400) - iterations(100), 300);
+}
+
+TEST(IntervalAnalysis, WideningIgnoresTripCount) {
+    auto loop = [](int bound, int step) {
+        std::string c = std::to_string(bound);
+        return "i = 0;\nwhile (i <= " + c + ") {\ni = i + " +
+               std::to_string(step) + ";\n}\ncheck_interval(i, " +
+               std::to_string(bound + 1) + ", " + std::to_string(bound + 1) +
+               ");\ncheck_interval(i, 0, 200);\n";
+    };
+
+    size_t shortLoop, longLoop;
+    EXPECT_EQ(runAnalysis(loop(10, 1), &shortLoop),
+              "Line 5: YES\nLine 6: YES\n");
+    EXPECT_EQ(runAnalysis(loop(200, 1), &longLoop),
+              "Line 5: YES\nLine 6:  NO\n");
+    EXPECT_EQ(shortLoop, longLoop);
+
+    // Widening leaves the last step of the loop unbounded, narrowing brings
+    // it back to 102
+    std::string src = "i = 0;\nwhile (i < 100) {\nif (i < 90) {\n"
+                      "i = i + 1;\n} else {\ni = i + 3;\n}\n}\n"
+                      "j = i - 100;\ncheck_interval(j, 0, 2);\n";
+    EXPECT_EQ(runAnalysis(src, nullptr, Mode::Dense, 0), "Line 10:  NO\n");
+    EXPECT_EQ(runAnalysis(src), "Line 10: YES\n");
+}
+
+TEST(IntervalAnalysis, SparseMatchesDense) {
+    std::vector<std::string> files = {
+        "branch1.fdlang",   "branch2.fdlang",   "corner.fdlang",
+        "deadcode1.fdlang", "deadcode2.fdlang", "loop1.fdlang",
+        "loop2.fdlang",     "loop3.fdlang",     "loop4.fdlang",
+        "loop5.fdlang",     "nobranch1.fdlang", "nobranch2.fdlang",
+        "nobranch3.fdlang", "rel1.fdlang",      "rel2.fdlang",
+        "rel3.fdlang",      "rel4.fdlang"};
+
+    for (auto &filepath : files) {
+        std::string src = readSrc(TESTCASES_DIR "/" + filepath);
+        EXPECT_EQ(runAnalysis(src, nullptr, Mode::Sparse), runAnalysis(src))
+            << filepath;
+    }
+}
+
+TEST(IntervalAnalysis, SparseNarrowingDropsBranches) {
+    // Widening takes `i' up to 159, so `k > 160' holds on some values until
+    // narrowing brings `i' back to [100, 106]
+    std::string src = "j = 5;\ni = 0;\nwhile (i < 100) {\ni = i + 7;\n}\n"
+                      "k = i + 50;\nif (k > 160) {\ncheck_interval(j, 0, 0);\n"
+                      "} else {\nnop;\n}\ncheck_interval(k, 0, 255);\n";
+    std::string expected = "Line 8: Unreachable\nLine 12: YES\n";
+
+    EXPECT_EQ(runAnalysis(src), expected);
+    EXPECT_EQ(runAnalysis(src, nullptr, Mode::Sparse), expected);
+}
+
+TEST(IntervalAnalysis, SparsePhisFollowDefinitions) {
+    // Many variables live across a loop which only defines `i' and `x'
+    std::string src;
+    for (size_t i = 0; i < 500; i++)
+        src += "v" + std::to_string(i) + " = input();\n";
+    src += "i = 0;\nwhile (i < 10) {\nx = v7 + i;\ni = i + 1;\n}\n"
+           "check_interval(i, 10, 10);\ncheck_interval(v7, 0, 255);\n";
+
+    fdlang::Scanner scanner(src);
+    fdlang::Parser parser(scanner);
+    fdlang::ASTNode *root = parser.parse();
+    fdlang::Sema sema(root);
+    EXPECT_TRUE(sema.check());
+    fdlang::IR::IRBuilder irBuilder(root);
+    fdlang::IR::Insts insts = irBuilder.build();
+
+    std::vector<Symbol> vars;
+    for (auto inst : insts)
+        for (size_t i = 0; i < inst->getOperandSize(); i++)
+            if (inst->getOperand(i)->isVariable())
+                vars.push_back(inst->getOperand(i)->getAsVariable());
+    std::sort(vars.begin(), vars.end());
+    vars.erase(std::unique(vars.begin(), vars.end()), vars.end());
+    analysis::VarEnv env(vars);
+
+    std::vector<std::array<size_t, 3>> operands(insts.size());
+    for (auto inst : insts)
+        for (size_t i = 0; i < inst->getOperandSize(); i++)
+            if (inst->getOperand(i)->isVariable())
+                operands[inst->getLabel()][i] =
+                    env.getID(inst->getOperand(i)->getAsVariable());
+
+    analysis::DefUseGraph graph(insts, operands, env.size());
+    std::map<std::string, size_t> phis;
+    for (auto &def : graph.getDefs())
+        if (def.kind == analysis::DefUseGraph::DefKind::Phi)
+            phis[env.getVar(def.var)]++;
+
+    // Only `i' and `x' merge at the loop head, the guard filters `i' on
+    // edges which do not merge
+    EXPECT_EQ(phis, (std::map<std::string, size_t>{{"i", 1}, {"x", 1}}));
+}
+
+std::string runFastAnalysis(const std::string &src) {
+    std::stringstream result;
+
+    fdlang::Scanner scanner(src);
+    fdlang::Parser parser(scanner);
+    fdlang::ASTNode *root = parser.parse();
+    EXPECT_FALSE(scanner.hadError());
+    EXPECT_FALSE(parser.hadError());
+
+    fdlang::Sema sema(root);
+    EXPECT_TRUE(sema.check());
+
+    fdlang::IR::IRBuilder irBuilder(root);
+    fdlang::IR::Insts insts = irBuilder.build();
+
+    fdlang::analysis::FastIntervalAnalysis analysis(insts);
+    analysis.run();
+    analysis.dumpResult(result);
+
+    return result.str();
+}
+
+TEST(FastIntervalAnalysis, ChunksMatchIntervalAnalysis) {
+    using fdlang::analysis::DBMKernel;
+    using fdlang::analysis::FastIntervalAnalysis;
+
+    // 100 variables spread over four chunks, with ranges and loops which
+    // keep them convex so that both analyses agree
+    std::string src;
+    for (int i = 0; i < 100; i++) {
+        std::string v = "v" + std::to_string(i), c = std::to_string(i);
+        src += v + " = input();\n";
+        src += "if (" + v + " > " + c + ") {\n" + v + " = " + v + " - " + c +
+               ";\n} else {\n" + v + " = " + c + " - " + v + ";\n}\n";
+        src += "while (" + v + " < 100) {\n" + v + " = " + v + " + " +
+               std::to_string(i % 7 + 1) + ";\n}\n";
+        src += "check_interval(" + v + ", 100, " + std::to_string(i % 7 + 99) +
+               ");\ncheck_interval(" + v + ", 100, 255);\n";
+    }
+
+    std::string expected = runAnalysis(src);
+    EXPECT_NE(expected.find(" NO"), std::string::npos);
+    for (auto kernel : {DBMKernel::Scalar, DBMKernel::SSE41, DBMKernel::AVX2}) {
+        if (!FastIntervalAnalysis::useKernel(kernel))
+            continue;
+        EXPECT_EQ(runFastAnalysis(src), expected)
+            << FastIntervalAnalysis::kernelName();
+    }
+    FastIntervalAnalysis::useKernel(DBMKernel::Best);
+}
+
+TEST(VarRange, SnapshotsShareNodes) {
+    using fdlang::analysis::ValueSet;
+    using fdlang::analysis::VarRange;
+    using fdlang::analysis::VarRangePool;
+
+    const size_t vars = 1000;
+    VarRangePool pool(vars);
+    VarRange state(pool, ValueSet(0, 0));
+
+    // Every snapshot changes one variable, and only adds its path
+    std::vector<VarRange> snapshots;
+    for (size_t i = 0; i < vars; i++) {
+        size_t before = pool.nodeCount();
+        state.insertVar(i * 7 % vars, ValueSet(i % 200, i % 200 + 5));
+        snapshots.push_back(state);
+        EXPECT_LE(pool.nodeCount() - before, pool.levels());
+    }
+    for (size_t i = 0; i < vars; i++)
+        EXPECT_EQ(snapshots.back().getVar(i * 7 % vars),
+                  ValueSet(i % 200, i % 200 + 5));
+
+    // The same values reached in another order are the same nodes
+    VarRange other(pool, ValueSet(0, 0));
+    for (size_t i = vars; i-- > 0;)
+        other.insertVar(i * 7 % vars, ValueSet(i % 200, i % 200 + 5));
+    EXPECT_TRUE(other.range_equal(snapshots.back()));
+    EXPECT_FALSE(other.range_equal(snapshots[vars / 2]));
+
+    // Joining a state it already includes leaves the root as it is
+    VarRange joined = snapshots[vars / 2];
+    EXPECT_TRUE(joined.range_union(snapshots.back()));
+    EXPECT_FALSE(joined.range_union(snapshots[vars / 2]));
+    EXPECT_FALSE(joined.range_union(joined));
+    EXPECT_FALSE(joined.range_union(snapshots.back()));
+}
+
+TEST(VarRange, SubtractSharedSubtrees) {
+    using fdlang::analysis::ValueSet;
+    using fdlang::analysis::VarRange;
+    using fdlang::analysis::VarRangePool;
+
+    const size_t vars = 100;
+    VarRangePool pool(vars);
+    VarRange state(pool, ValueSet(0, 10));
+
+    // Subtracting a state from itself empties every variable
+    VarRange self = state;
+    EXPECT_TRUE(self.range_subtract(state));
+    for (size_t i = 0; i < vars; i++)
+        EXPECT_TRUE(self.getVar(i).isEmpty()) << i;
+
+    // Only the path to the changed variable differs, the rest is shared
+    VarRange other = state;
+    other.insertVar(42, ValueSet(5, 20));
+    VarRange diff = other;
+    EXPECT_TRUE(diff.range_subtract(state));
+    for (size_t i = 0; i < vars; i++)
+        EXPECT_EQ(diff.getVar(i), i == 42 ? ValueSet(11, 20) : ValueSet())
+            << i;
+}
+
+TEST(ValueSet, MatchesBruteForce) {
+    using fdlang::analysis::ValueSet;
+    using Bits = std::bitset<256>;
+
+    std::mt19937 rng(1);
+    auto randomSet = [&](Bits &bits) {
+        ValueSet set;
+        bits.reset();
+        for (int runs = rng() % 4; runs > 0; runs--) {
+            int s = rng() % 256, e = std::min(255, s + (int)(rng() % 80));
+            set.joinWith(ValueSet(s, e));
+            for (int v = s; v <= e; v++)
+                bits.set(v);
+        }
+        return set;
+    };
+    auto same = [](const ValueSet &set, const Bits &bits) {
+        for (int v = 0; v < 256; v++)
+            if (set.contains(v) != bits[v])
+                return false;
+        return true;
+    };
+
+    for (int round = 0; round < 500; round++) {
+        Bits a, b, sum, diff, shifted;
+        ValueSet x = randomSet(a), y = randomSet(b);
+        int c = (int)(rng() % 521) - 260, first = 256, last = -1;
+        for (int i = 0; i < 256; i++) {
+            if (!a[i])
+                continue;
+            first = std::min(first, i), last = i;
+            shifted.set(std::clamp(i + c, 0, 255));
+            for (int j = 0; j < 256; j++) {
+                if (!b[j])
+                    continue;
+                sum.set(std::min(i + j, 255));
+                diff.set(std::max(i - j, 0));
+            }
+        }
+
+        EXPECT_TRUE(same(x.add(y), sum));
+        EXPECT_TRUE(same(x.sub(y), diff));
+        EXPECT_TRUE(same(x.add(c), shifted)) << c;
+        EXPECT_EQ(x.subsetOf(y), (a & ~b).none());
+        EXPECT_EQ(x.min(), first);
+        EXPECT_EQ(x.max(), last);
+
+        ValueSet joined = x, met = x, removed = x;
+        EXPECT_EQ(joined.joinWith(y), (a | b) != a);
+        EXPECT_EQ(met.meetWith(y), (a & b) != a);
+        EXPECT_EQ(removed.remove(y), (a & ~b) != a);
+        EXPECT_TRUE(same(joined, a | b));
+        EXPECT_TRUE(same(met, a & b));
+        EXPECT_TRUE(same(removed, a & ~b));
+    }
+}
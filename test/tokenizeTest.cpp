@@ -2,6 +2,7 @@
 
 #include "fdlang/scanner.h"
 
+#include <climits>
 #include <numeric>
 #include <vector>
 
@@ -86,16 +87,76 @@ TEST(Tokenize, Number) {
     for (int i = 0; i < tokens.size(); i++) {
         if (tokens[i].type == TokenType::END_OF_FILE)
             continue;
-        if (!tokens[i].literal.has_value() ||
-            tokens[i].literal.type() != typeid(long long)) {
-            eq = false;
-            break;
-        }
-        if (std::any_cast<long long>(tokens[i].literal) != expected[i]) {
+        if (tokens[i].type != TokenType::NUMBER ||
+            tokens[i].literal != expected[i]) {
             eq = false;
             break;
         }
     }
 
     EXPECT_TRUE(eq);
-}
\ No newline at end of file
+}
+
+TEST(Tokenize, ZeroCopy) {
+    std::string src = "abc = 99999999999999999999999;\n  x1 = abc + 7;";
+    std::vector<Token> tokens = scan(src);
+
+    ASSERT_EQ(tokens.size(), 11u);
+    EXPECT_EQ(tokens[2].literal, LLONG_MAX);
+    EXPECT_EQ(tokens[4].line, 2u);
+    EXPECT_EQ(tokens[8].literal, 7);
+
+    // Lexemes are views of the source
+    for (auto &token : tokens) {
+        if (token.type == TokenType::END_OF_FILE)
+            continue;
+        EXPECT_GE(token.lexeme.data(), src.data());
+        EXPECT_LE(token.lexeme.data() + token.lexeme.size(),
+                  src.data() + src.size());
+    }
+}
+
+TEST(Tokenize, UnexpectedCharacter) {
+    Scanner scanner("a = 1 $ 2;");
+    scanner.scanTokens();
+    EXPECT_TRUE(scanner.hadError());
+}
+
+TEST(Tokenize, Symbols) {
+    std::string src = "alpha = beta; beta = alpha + alpha;";
+    std::vector<Token> tokens = scan(src);
+    std::vector<Token> again = scan("beta = 1;");
+
+    EXPECT_EQ(tokens[0].getSymbol(), tokens[6].getSymbol());
+    EXPECT_EQ(tokens[0].getSymbol(), tokens[8].getSymbol());
+    EXPECT_NE(tokens[0].getSymbol(), tokens[2].getSymbol());
+    EXPECT_EQ(again[0].getSymbol(), tokens[2].getSymbol());
+    EXPECT_EQ(SymbolTable::get().getName(tokens[2].getSymbol()), "beta");
+}
+
+TEST(Tokenize, Kernels) {
+    // Runs longer than a vector and straddling its boundaries
+    std::string src;
+    for (size_t n = 1; n <= 70; n++) {
+        src += std::string(n, 'a') + "_Z9" + std::string(n % 7, ' ');
+        src += std::string(n % 5, '\n') + std::string(n, '7') + "\t\r";
+        src += std::string(n, ' ') + "while" + std::string(n % 3, '\n');
+        src += "check_interval(";
+    }
+
+    ASSERT_TRUE(Scanner::useKernel(ScanKernel::Scalar));
+    std::vector<Token> expected = scan(src);
+    for (ScanKernel kernel : {ScanKernel::SSE2, ScanKernel::AVX2}) {
+        if (!Scanner::useKernel(kernel))
+            continue;
+        std::vector<Token> tokens = scan(src);
+        ASSERT_EQ(tokens.size(), expected.size()) << Scanner::kernelName();
+        for (size_t i = 0; i < tokens.size(); i++) {
+            EXPECT_EQ(tokens[i].type, expected[i].type);
+            EXPECT_EQ(tokens[i].lexeme, expected[i].lexeme);
+            EXPECT_EQ(tokens[i].literal, expected[i].literal);
+            EXPECT_EQ(tokens[i].line, expected[i].line);
+        }
+    }
+    Scanner::useKernel(ScanKernel::Best);
+}
@@ -6,19 +6,54 @@
 #include "fdlang/scanner.h"
 #include "fdlang/sema.h"
 
+#include "analysis/dbm.h"
 #include "analysis/modelChecker.h"
 #include "analysis/relationalNumericalAnalysis.h"
+#include "analysis/variableOrder.h"
 
 #include "IR/IRBuilder.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
+#include <new>
+#include <random>
 #include <sstream>
 
 using namespace fdlang;
 
 size_t total, true_positive, false_positive, false_negtive;
 
+// Heap allocations made while `countAllocations' is set
+size_t allocations = 0;
+bool countAllocations = false;
+
+void *operator new(size_t size) {
+    allocations += countAllocations;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    allocations += countAllocations;
+    size_t align = (size_t)alignment;
+    if (void *p = std::aligned_alloc(align, (size + align - 1) / align * align))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+
+void operator delete(void *p, size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
 std::string readSrc(const std::string &path) {
     std::ifstream file(path);
     file.seekg(0, std::ios::end);
@@ -71,17 +106,17 @@ void compare(const std::string &our, const std::string &expected) {
     }
 }
 
-void check(std::string &filepath) {
-    std::string src = readSrc(TESTCASES_DIR "/" + filepath);
-    std::string expected = readSrc(TESTCASES_DIR "/" + filepath + ".expected");
+std::string
+runAnalysis(const std::string &src,
+            analysis::RelationalNumericalAnalysis::ZoneKind kind =
+                analysis::RelationalNumericalAnalysis::ZoneKind::Auto,
+            size_t *iterations = nullptr) {
     std::stringstream result;
 
     fdlang::Scanner scanner(src);
-    std::vector<fdlang::Token> tokens = scanner.scanTokens();
-    EXPECT_FALSE(scanner.hadError());
-
-    fdlang::Parser parser(tokens);
+    fdlang::Parser parser(scanner);
     fdlang::ASTNode *root = parser.parse();
+    EXPECT_FALSE(scanner.hadError());
     EXPECT_FALSE(parser.hadError());
 
     fdlang::Sema sema(root);
@@ -90,23 +125,32 @@ void check(std::string &filepath) {
     fdlang::IR::IRBuilder irBuilder(root);
     fdlang::IR::Insts insts = irBuilder.build();
 
-    fdlang::analysis::RelationalNumericalAnalysis analysis(insts);
+    fdlang::analysis::RelationalNumericalAnalysis analysis(insts, kind);
     analysis.run();
     analysis.dumpResult(result);
+    if (iterations)
+        *iterations = analysis.getIterations();
 
-    compare(result.str(), expected);
+    return result.str();
 }
 
-TEST(RelationalNumericalAnalysis, RunAll) {
+void check(std::string &filepath) {
+    std::string src = readSrc(TESTCASES_DIR "/" + filepath);
+    std::string expected = readSrc(TESTCASES_DIR "/" + filepath + ".expected");
 
-    std::vector<std::string> files = {
-        "branch1.fdlang",   "branch2.fdlang",   "corner.fdlang",
-        "deadcode1.fdlang", "deadcode2.fdlang", "loop1.fdlang",
-        "loop2.fdlang",     "loop3.fdlang",     "loop4.fdlang",
-        "loop5.fdlang",     "nobranch1.fdlang", "nobranch2.fdlang",
-        "nobranch3.fdlang", "rel1.fdlang",      "rel2.fdlang",
-        "rel3.fdlang",      "rel4.fdlang"};
+    compare(runAnalysis(src), expected);
+}
+
+std::vector<std::string> files = {
+    "branch1.fdlang",   "branch2.fdlang",   "corner.fdlang",
+    "deadcode1.fdlang", "deadcode2.fdlang", "loop1.fdlang",
+    "loop2.fdlang",     "loop3.fdlang",     "loop4.fdlang",
+    "loop5.fdlang",     "nobranch1.fdlang", "nobranch2.fdlang",
+    "nobranch3.fdlang", "rel1.fdlang",      "rel2.fdlang",
+    "rel3.fdlang",      "rel4.fdlang"};
 
+TEST(RelationalNumericalAnalysis, RunAll) {
+    analysis::ZoneDomain::resetStats();
     for (auto &filepath : files)
         check(filepath);
 
@@ -121,4 +165,233 @@ TEST(RelationalNumericalAnalysis, RunAll) {
     if (true_positive + false_negtive == 0)
         recall = 0;
     printf("Recall: %.3lf%%\n", recall);
-}
\ No newline at end of file
+
+    const analysis::ZoneDomain::Stats &stats = analysis::ZoneDomain::getStats();
+    printf("Closures: %lu full, %lu incremental, %lu avoided\n",
+           stats.fullClosures, stats.incrementalClosures,
+           stats.avoidedClosures);
+}
+
+TEST(RelationalNumericalAnalysis, SplitMatchesDense) {
+    using ZoneKind = analysis::RelationalNumericalAnalysis::ZoneKind;
+
+    for (auto &filepath : files) {
+        std::string src = readSrc(TESTCASES_DIR "/" + filepath);
+        EXPECT_EQ(runAnalysis(src, ZoneKind::Dense),
+                  runAnalysis(src, ZoneKind::Split))
+            << filepath;
+    }
+
+    // Loops whose bounds widen while the relations between their counters
+    // stay stable
+    std::string src = "i = 0;\nj = 10;\nk = input();\nwhile (i < 100) {\n"
+                      "i = i + 3;\nj = j + 3;\nif (k > 200) {\nk = k - 1;\n"
+                      "} else {\nnop;\n}\n}\ncheck_interval(j, 110, 112);\n"
+                      "check_interval(k, 0, 200);\n";
+    EXPECT_EQ(runAnalysis(src, ZoneKind::Dense),
+              "Line 13: YES\nLine 14:  NO\n");
+    EXPECT_EQ(runAnalysis(src, ZoneKind::Split),
+              "Line 13: YES\nLine 14:  NO\n");
+}
+
+TEST(RelationalNumericalAnalysis, FixedMatchesDense) {
+    using ZoneKind = analysis::RelationalNumericalAnalysis::ZoneKind;
+
+    for (auto &filepath : files) {
+        std::string src = readSrc(TESTCASES_DIR "/" + filepath);
+        EXPECT_EQ(runAnalysis(src, ZoneKind::Dense),
+                  runAnalysis(src, ZoneKind::Fixed))
+            << filepath;
+    }
+}
+
+TEST(RelationalNumericalAnalysis, WideningIgnoresTripCount) {
+    using ZoneKind = analysis::RelationalNumericalAnalysis::ZoneKind;
+
+    auto loop = [](int bound) {
+        std::string c = std::to_string(bound);
+        return "i = 0;\nj = 0;\nwhile (i <= " + c +
+               ") {\ni = i + 1;\nj = j + 1;\n}\ncheck_interval(i, " +
+               std::to_string(bound + 1) + ", " + std::to_string(bound + 1) +
+               ");\ncheck_interval(j, 0, " + std::to_string(bound + 1) +
+               ");\n";
+    };
+
+    for (ZoneKind kind : {ZoneKind::Dense, ZoneKind::Split, ZoneKind::Fixed,
+                          ZoneKind::Octagon}) {
+        size_t shortLoop, longLoop;
+        EXPECT_EQ(runAnalysis(loop(10), kind, &shortLoop),
+                  "Line 7: YES\nLine 8: YES\n");
+        EXPECT_EQ(runAnalysis(loop(200), kind, &longLoop),
+                  "Line 7: YES\nLine 8: YES\n");
+        EXPECT_EQ(shortLoop, longLoop);
+    }
+}
+
+TEST(RelationalNumericalAnalysis, OctagonTracksSums) {
+    using ZoneKind = analysis::RelationalNumericalAnalysis::ZoneKind;
+
+    std::string src = "x = input();\nif (x <= 100) {\ny = 100 - x;\nz = x + "
+                      "y;\ncheck_interval(z, 100, 100);\n} else {\nz = 0;\n}\n";
+    EXPECT_EQ(runAnalysis(src, ZoneKind::Dense), "Line 5:  NO\n");
+    EXPECT_EQ(runAnalysis(src, ZoneKind::Octagon), "Line 5: YES\n");
+
+    // Saturation keeps `x' from tracking `y' once `y - 10' may hit zero
+    src = "y = input();\nx = y - 10;\ncheck_interval(x, 0, 245);\n"
+          "z = y - x;\ncheck_interval(z, 10, 10);\n";
+    EXPECT_EQ(runAnalysis(src, ZoneKind::Octagon),
+              "Line 3: YES\nLine 5:  NO\n");
+}
+
+TEST(RelationalNumericalAnalysis, ThreadsOnlyCloseLargeOctagons) {
+    using ZoneKind = analysis::RelationalNumericalAnalysis::ZoneKind;
+
+    // 260 related variables, over `SPLIT_THRESHOLD' and so split as zones,
+    // and 520 rows, over `BLOCKED_THRESHOLD', as an octagon
+    std::string src = "v0 = input();\n";
+    for (size_t i = 1; i < 260; i++)
+        src += "v" + std::to_string(i) + " = v" + std::to_string(i - 1) +
+               " + 0;\n";
+    src += "while (v0 < 10) {\nv0 = v0 + 1;\n}\n"
+           "check_interval(v259, 0, 255);\n";
+
+    analysis::DBM::useThreads(1);
+    std::string plain = runAnalysis(src, ZoneKind::Octagon);
+
+    analysis::DBM::useThreads(4);
+    analysis::DBM::resetStats();
+    runAnalysis(src);
+    EXPECT_EQ(analysis::DBM::getStats().blockedClosures, 0);
+    EXPECT_EQ(runAnalysis(src, ZoneKind::Octagon), plain);
+    EXPECT_GT(analysis::DBM::getStats().blockedClosures, 0);
+    analysis::DBM::useThreads(1);
+}
+
+TEST(RelationalNumericalAnalysis, ThreadsCloseLargeDenseZones) {
+    // 160 variables, over `SPLIT_THRESHOLD', related in one component which
+    // the widening of `v0' closes again
+    std::string related = "v0 = 0;\n";
+    for (size_t i = 1; i < 160; i++)
+        related += "v" + std::to_string(i) + " = v" + std::to_string(i - 1) +
+                   " + 1;\n";
+    related += "while (v0 < 10) {\nv0 = v0 + 1;\nv159 = v0 + 159;\n}\n"
+               "check_interval(v159, 169, 255);\n"
+               "check_interval(v80, 80, 90);\n";
+    // As many variables without any relation
+    std::string unrelated;
+    for (size_t i = 0; i < 160; i++)
+        unrelated += "v" + std::to_string(i) + " = input();\n";
+    unrelated += "check_interval(v159, 0, 255);\n";
+
+    analysis::DBM::useThreads(1);
+    std::string plainRelated = runAnalysis(related);
+    std::string plainUnrelated = runAnalysis(unrelated);
+    EXPECT_EQ(plainRelated, "Line 165: YES\nLine 166: YES\n");
+
+    // Only the component of 160 variables reaches the tiled closure
+    analysis::DBM::useThreads(4, 128);
+    analysis::DBM::resetStats();
+    EXPECT_EQ(runAnalysis(unrelated), plainUnrelated);
+    EXPECT_EQ(analysis::DBM::getStats().blockedClosures, 0);
+    EXPECT_EQ(runAnalysis(related), plainRelated);
+    EXPECT_GT(analysis::DBM::getStats().blockedClosures, 0);
+    analysis::DBM::useThreads(1);
+}
+
+TEST(RelationalNumericalAnalysis, SaturationKeepsStatesReachable) {
+    using ZoneKind = analysis::RelationalNumericalAnalysis::ZoneKind;
+
+    // `b' stops at 255 for a > 246, `c' and `d' stop at 0
+    std::string src = "a = input();\nb = a;\nb = b + 9;\nif (a > 250) {\n"
+                      "check_interval(b, 251, 255);\n} else {\nnop;\n}\n"
+                      "c = b - 20;\ncheck_interval(c, 0, 244);\n"
+                      "d = 3 - 10;\ncheck_interval(d, 0, 0);\n";
+    for (ZoneKind kind : {ZoneKind::Dense, ZoneKind::Split, ZoneKind::Fixed,
+                          ZoneKind::Octagon})
+        EXPECT_EQ(runAnalysis(src, kind),
+                  "Line 5: YES\nLine 10: YES\nLine 12: YES\n");
+}
+
+TEST(RelationalNumericalAnalysis, ReverseCuthillMcKeeBandsGraphs) {
+    // Largest distance between the positions of two neighbours
+    auto bandwidth = [](const std::vector<std::vector<size_t>> &adj) {
+        std::vector<size_t> order = analysis::reverseCuthillMcKee(adj);
+        std::vector<size_t> position(adj.size(), adj.size());
+        for (size_t p = 0; p < order.size(); p++)
+            position[order[p]] = p;
+        size_t width = 0;
+        for (size_t u = 0; u < adj.size(); u++) {
+            EXPECT_LT(position[u], adj.size());
+            for (size_t v : adj[u])
+                width = std::max(width, position[u] > position[v]
+                                            ? position[u] - position[v]
+                                            : position[v] - position[u]);
+        }
+        return width;
+    };
+
+    // Paths and grids with their vertices shuffled
+    std::mt19937 rng(1);
+    auto grid = [&](size_t rows, size_t cols) {
+        std::vector<size_t> label(rows * cols);
+        for (size_t v = 0; v < label.size(); v++)
+            label[v] = v;
+        std::shuffle(label.begin(), label.end(), rng);
+        std::vector<std::vector<size_t>> adj(label.size());
+        auto link = [&](size_t a, size_t b) {
+            adj[label[a]].push_back(label[b]);
+            adj[label[b]].push_back(label[a]);
+        };
+        for (size_t r = 0; r < rows; r++) {
+            for (size_t c = 0; c < cols; c++) {
+                if (c + 1 < cols)
+                    link(r * cols + c, r * cols + c + 1);
+                if (r + 1 < rows)
+                    link(r * cols + c, (r + 1) * cols + c);
+            }
+        }
+        return adj;
+    };
+    EXPECT_EQ(bandwidth(grid(1, 50)), 1);
+    EXPECT_LE(bandwidth(grid(8, 30)), 8);
+
+    // Two components and an isolated vertex
+    EXPECT_EQ(bandwidth({{1}, {0, 2}, {1}, {}, {5}, {4}}), 1);
+}
+
+TEST(RelationalNumericalAnalysis, SteadyStateDoesNotAllocate) {
+    using ZoneKind = analysis::RelationalNumericalAnalysis::ZoneKind;
+
+    // Every label is reached in the first pass, then nested loops keep the
+    // fixpoint going on states which already have their storage
+    std::string src = "i = input();\nk = input();\ns = 0;\nwhile (i < 50) {\n"
+                      "j = 0;\nwhile (j < 10) {\nj = j + 1;\ns = k - j;\n"
+                      "if (s <= 20) {\ns = s + 2;\n} else {\nk = j + 3;\n}\n"
+                      "}\ni = i + 1;\n}\ncheck_interval(i, 50, 50);\n";
+
+    fdlang::Scanner scanner(src);
+    fdlang::Parser parser(scanner);
+    fdlang::ASTNode *root = parser.parse();
+    fdlang::Sema sema(root);
+    ASSERT_TRUE(sema.check());
+    fdlang::IR::IRBuilder irBuilder(root);
+    fdlang::IR::Insts insts = irBuilder.build();
+
+    // Split zones are left out: a label's adjacency list still grows the
+    // first time the narrowing stores a relation that label never held
+    for (ZoneKind kind :
+         {ZoneKind::Dense, ZoneKind::Fixed, ZoneKind::Octagon}) {
+        analysis::RelationalNumericalAnalysis analysis(insts, kind);
+        std::vector<size_t> counts;
+        counts.reserve(1 << 16);
+        analysis.setTransferHook(
+            [&](size_t) { counts.push_back(allocations); });
+
+        countAllocations = true;
+        analysis.run();
+        countAllocations = false;
+
+        ASSERT_GT(counts.size(), 20u);
+        EXPECT_EQ(counts[counts.size() / 2], counts.back()) << (int)kind;
+    }
+}
@@ -1,37 +1,24 @@
 #include "fdlang/AST.h"
 #include "fdlang/ASTTraversePrinter.h"
+#include "fdlang/flatAST.h"
 #include "fdlang/parser.h"
 #include "fdlang/scanner.h"
 #include "fdlang/sema.h"
+#include "fdlang/sourceBuffer.h"
 
+#include "analysis/fastIntervalAnalysis.h"
 #include "analysis/intervalAnalysis.h"
 #include "analysis/modelChecker.h"
 #include "analysis/relationalNumericalAnalysis.h"
 
 #include "IR/IRBuilder.h"
 
-#include <fstream>
+#include <algorithm>
+#include <cctype>
 #include <iostream>
 
 std::set<std::string> options;
 
-std::string readSrc(const std::string &path) {
-    std::ifstream file(path);
-    file.seekg(0, std::ios::end);
-    std::streamoff fileLength = file.tellg();
-    file.seekg(0, std::ios::beg);
-
-    char *buffer = new char[fileLength + 1];
-    file.read(buffer, fileLength);
-    buffer[fileLength] = '\0';
-    std::string ret = buffer;
-
-    if (buffer)
-        delete[] buffer;
-
-    return ret;
-}
-
 int main(int argc, char *argv[]) {
 
     if (argc == 1) {
@@ -39,7 +26,11 @@ int main(int argc, char *argv[]) {
                      "[-format] "
                      "[-modelchecker] "
                      "[-interval-analysis] "
+                     "[-fast-interval] "
+                     "[-sparse-interval] "
                      "[-zone-analysis] "
+                     "[-zone-threads=N[,min]] "
+                     "[-octagon-analysis] "
                      "[-dumpir] "
                      "path-to-src-file"
                   << std::endl;
@@ -57,37 +48,83 @@ int main(int argc, char *argv[]) {
     bool doModelChecker = options.count("-modelchecker");
     bool doDumpir = options.count("-dumpir");
     bool doIntervalAnalysis = options.count("-interval-analysis");
+    bool doFastInterval = options.count("-fast-interval");
+    bool doSparseInterval = options.count("-sparse-interval");
     bool doZoneAnalysis = options.count("-zone-analysis");
+    bool doOctagonAnalysis = options.count("-octagon-analysis");
+
+    // Threads closing the matrices of `min' variables or more by tiles, see
+    // `DBM::useThreads'
+    const std::string zoneThreads = "-zone-threads=";
+    auto isCount = [](const std::string &value) {
+        return !value.empty() && value.size() <= 4 &&
+               std::all_of(value.begin(), value.end(), ::isdigit);
+    };
+    for (auto &option : options) {
+        if (option.compare(0, zoneThreads.size(), zoneThreads) != 0)
+            continue;
+        std::string value = option.substr(zoneThreads.size());
+        size_t comma = value.find(',');
+        std::string threads = value.substr(0, comma);
+        if (!isCount(threads)) {
+            std::cerr << "Invalid thread count in " << option << std::endl;
+            return 1;
+        }
+        size_t minSize = fdlang::analysis::DBM::BLOCKED_THRESHOLD;
+        if (comma != std::string::npos) {
+            std::string size = value.substr(comma + 1);
+            if (!isCount(size) || std::stoul(size) == 0) {
+                std::cerr << "Invalid matrix size in " << option << std::endl;
+                return 1;
+            }
+            minSize = std::stoul(size);
+        }
+        fdlang::analysis::DBM::useThreads(std::stoul(threads), minSize);
+    }
 
-    std::string src = readSrc(filepath);
-    fdlang::Scanner scanner(src);
-    std::vector<fdlang::Token> tokens = scanner.scanTokens();
-    if (scanner.hadError())
-        return 0;
-
-    fdlang::Parser parser(tokens);
-    fdlang::ASTNode *root = parser.parse();
-    if (parser.hadError())
-        return 0;
-
-    fdlang::Sema sema(root);
-    if (!sema.check())
+    // The tokens, the AST and the IR point into the source
+    fdlang::SourceBuffer src(filepath);
+    if (!src.isOpen()) {
+        std::cerr << "Cannot read " << filepath << std::endl;
+        return 1;
+    }
+    fdlang::Scanner scanner(src.text());
+    fdlang::Parser parser(scanner);
+    bool doIR = doIntervalAnalysis || doFastInterval || doSparseInterval ||
+                doZoneAnalysis || doOctagonAnalysis || doDumpir;
+
+    // Formatting and model checking need the whole program, kept as a flat
+    // AST, otherwise each top-level statement is lowered to IR and freed as
+    // soon as it is parsed
+    bool wholeAST = doFormat || doModelChecker;
+    fdlang::FlatAST ast;
+    if (wholeAST) {
+        ast = parser.parseFlat();
+        if (parser.hadError())
+            return 0;
+
+        fdlang::Sema sema(ast);
+        if (!sema.check())
+            return 0;
+    }
+    fdlang::IR::IRBuilder irBuilder(ast);
+    if (!wholeAST && !irBuilder.stream(parser))
         return 0;
 
     if (doFormat) {
         fdlang::ASTTraversePrinter printer(std::cout);
-        root->accept(&printer);
+        printer.print(ast);
     }
 
     if (doModelChecker) {
-        fdlang::analysis::NaiveModelChecker modelChecker(root);
+        fdlang::analysis::NaiveModelChecker modelChecker(ast);
         modelChecker.run();
         modelChecker.dumpResult(std::cout);
     }
 
-    if (doIntervalAnalysis || doZoneAnalysis || doDumpir) {
-        fdlang::IR::IRBuilder irBuilder(root);
-        fdlang::IR::Insts insts = irBuilder.build();
+    if (doIR) {
+        fdlang::IR::Insts insts =
+            wholeAST ? irBuilder.build() : irBuilder.finish();
 
         if (doDumpir) {
             for (auto inst : insts) {
@@ -102,11 +139,32 @@ int main(int argc, char *argv[]) {
             analysis.dumpResult(std::cout);
         }
 
+        if (doSparseInterval) {
+            fdlang::analysis::IntervalAnalysis analysis(
+                insts, fdlang::analysis::IntervalAnalysis::Mode::Sparse);
+            analysis.run();
+            analysis.dumpResult(std::cout);
+        }
+
+        if (doFastInterval) {
+            fdlang::analysis::FastIntervalAnalysis analysis(insts);
+            analysis.run();
+            analysis.dumpResult(std::cout);
+        }
+
         if (doZoneAnalysis) {
             fdlang::analysis::RelationalNumericalAnalysis analysis(insts);
             analysis.run();
             analysis.dumpResult(std::cout);
         }
+
+        if (doOctagonAnalysis) {
+            fdlang::analysis::RelationalNumericalAnalysis analysis(
+                insts, fdlang::analysis::RelationalNumericalAnalysis::ZoneKind::
+                           Octagon);
+            analysis.run();
+            analysis.dumpResult(std::cout);
+        }
     }
 
     return 0;